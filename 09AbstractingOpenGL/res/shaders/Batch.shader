@@ -0,0 +1,55 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec2 texCoord;
+layout(location = 3) in float texIndex;
+
+out vec4 v_Color;
+out vec2 v_TexCoord;
+flat out int v_TexIndex;
+
+void main()
+{
+    v_Color = color;
+    v_TexCoord = texCoord;
+    v_TexIndex = int(texIndex);
+    gl_Position = vec4(position, 0.0, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_Color;
+in vec2 v_TexCoord;
+flat in int v_TexIndex;
+
+uniform sampler2D u_Textures[16];
+
+void main()
+{
+    //GLSL 3.30 only lets us index sampler arrays with constants.
+    vec4 texel;
+    switch (v_TexIndex) {
+        case 0: texel = texture(u_Textures[0], v_TexCoord); break;
+        case 1: texel = texture(u_Textures[1], v_TexCoord); break;
+        case 2: texel = texture(u_Textures[2], v_TexCoord); break;
+        case 3: texel = texture(u_Textures[3], v_TexCoord); break;
+        case 4: texel = texture(u_Textures[4], v_TexCoord); break;
+        case 5: texel = texture(u_Textures[5], v_TexCoord); break;
+        case 6: texel = texture(u_Textures[6], v_TexCoord); break;
+        case 7: texel = texture(u_Textures[7], v_TexCoord); break;
+        case 8: texel = texture(u_Textures[8], v_TexCoord); break;
+        case 9: texel = texture(u_Textures[9], v_TexCoord); break;
+        case 10: texel = texture(u_Textures[10], v_TexCoord); break;
+        case 11: texel = texture(u_Textures[11], v_TexCoord); break;
+        case 12: texel = texture(u_Textures[12], v_TexCoord); break;
+        case 13: texel = texture(u_Textures[13], v_TexCoord); break;
+        case 14: texel = texture(u_Textures[14], v_TexCoord); break;
+        default: texel = texture(u_Textures[15], v_TexCoord); break;
+    }
+    color = v_Color * texel;
+};
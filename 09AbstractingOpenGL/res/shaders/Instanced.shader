@@ -0,0 +1,26 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 offset;   //per instance
+layout(location = 2) in vec4 color;    //per instance
+
+out vec4 v_Color;
+
+void main()
+{
+    v_Color = color;
+    gl_Position = vec4(position.xy + offset, position.zw);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_Color;
+
+void main()
+{
+    color = v_Color;
+};
@@ -0,0 +1,28 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec4 placement; //per instance: xyz the center, w the scale
+layout(location = 2) in vec4 color;     //per instance
+
+uniform mat4 u_ViewProjection;
+
+out vec4 v_Color;
+
+void main()
+{
+    v_Color = color;
+    gl_Position = u_ViewProjection * vec4(position * placement.w + placement.xyz, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_Color;
+
+void main()
+{
+    color = v_Color;
+};
@@ -0,0 +1,32 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texCoord;
+layout(location = 3) in vec4 color;
+layout(location = 4) in vec4 tangent;   //w is the handedness
+
+out vec4 v_Color;
+
+void main()
+{
+    vec3 light = normalize(vec3(0.3, 0.5, 1.0));
+    float diffuse = max(dot(normal, light), 0.0);
+    float rim = abs(dot(tangent.xyz, light)) * tangent.w;
+
+    v_Color = vec4(color.rgb * (0.2 + 0.8 * diffuse) + 0.1 * rim, color.a) * vec4(texCoord, 1.0, 1.0);
+    gl_Position = vec4(position, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_Color;
+
+void main()
+{
+    color = v_Color;
+};
@@ -0,0 +1,42 @@
+#shader vertex
+#version 330 core
+
+//the same as Mesh.shader with the attributes from VertexPacking. Halves and normalized
+//integers arrive as floats, only the octahedral normal has to be unfolded.
+layout(location = 0) in vec3 position;  //half
+layout(location = 1) in vec2 normal;    //octahedral, snorm16
+layout(location = 2) in vec2 texCoord;  //unorm16
+layout(location = 3) in vec4 color;     //unorm8
+layout(location = 4) in vec4 tangent;   //snorm 10_10_10_2
+
+out vec4 v_Color;
+
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main()
+{
+    vec3 light = normalize(vec3(0.3, 0.5, 1.0));
+    float diffuse = max(dot(OctahedralDecode(normal), light), 0.0);
+    float rim = abs(dot(tangent.xyz, light)) * tangent.w;
+
+    v_Color = vec4(color.rgb * (0.2 + 0.8 * diffuse) + 0.1 * rim, color.a) * vec4(texCoord, 1.0, 1.0);
+    gl_Position = vec4(position, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_Color;
+
+void main()
+{
+    color = v_Color;
+};
@@ -0,0 +1,23 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+
+uniform vec2 u_Offset;
+
+void main()
+{
+    gl_Position = vec4(position.xy + u_Offset, position.zw);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+uniform vec4 u_Color;
+
+void main()
+{
+    color = u_Color;
+};
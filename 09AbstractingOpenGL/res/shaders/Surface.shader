@@ -0,0 +1,57 @@
+#keywords VERTEX_COLOR TEXTURED INSTANCING
+
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec2 position;
+#ifdef VERTEX_COLOR
+layout(location = 1) in vec4 color;
+out vec4 v_Color;
+#endif
+#ifdef TEXTURED
+layout(location = 2) in vec2 texCoord;
+out vec2 v_TexCoord;
+#endif
+#ifdef INSTANCING
+layout(location = 3) in vec2 offset;   //per instance
+#endif
+
+void main()
+{
+#ifdef VERTEX_COLOR
+    v_Color = color;
+#endif
+#ifdef TEXTURED
+    v_TexCoord = texCoord;
+#endif
+#ifdef INSTANCING
+    gl_Position = vec4(position + offset, 0.0, 1.0);
+#else
+    gl_Position = vec4(position, 0.0, 1.0);
+#endif
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+uniform vec4 u_Color;
+#ifdef VERTEX_COLOR
+in vec4 v_Color;
+#endif
+#ifdef TEXTURED
+in vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+#endif
+
+void main()
+{
+    color = u_Color;
+#ifdef VERTEX_COLOR
+    color *= v_Color;
+#endif
+#ifdef TEXTURED
+    color *= texture(u_Texture, v_TexCoord);
+#endif
+};
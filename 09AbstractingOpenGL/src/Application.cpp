@@ -6,169 +6,148 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 
 #include "Renderer.h"
 
 #include "VertexBuffer.h"
+#include "VertexArray.h"
 #include "IndexBuffer.h"
+#include "Shader.h"
+#include "ShaderQueue.h"
+#include "ShaderWatcher.h"
+#include "HeadlessContext.h"
+#include "Benchmark.h"
+#include "GpuProfiler.h"
+#include "GLState.h"
+#include "ProgramCache.h"
 
-struct ShaderProgramSource
-{
-    std::string VertexSource;
-    std::string FragmentSource;
-};
-
-static ShaderProgramSource ParseShader(const std::string& filepath)
+/*
+* Writes the GLCall profile to path, as JSON if it ends in .json and as CSV otherwise.
+*/
+static void WriteGLCallProfile(const char* path)
 {
-    std::ifstream stream(filepath);
-
-    enum class ShaderType
-    {
-        NONE = -1,
-        VERTEX = 0,
-        FRAGMENT = 1
-    };
-
-    std::string line;
-    std::stringstream ss[2];
-    ShaderType type = ShaderType::NONE;
-
-    while (std::getline(stream, line)) {
-
-        //if we find a new section...
-        if (line.find("#shader") != std::string::npos) {
-            if (line.find("vertex") != std::string::npos) {
-                type = ShaderType::VERTEX;
-            }
-            else if (line.find("fragment") != std::string::npos) {
-                type = ShaderType::FRAGMENT;
-            }
+    size_t length = strlen(path);
+    bool json = length >= 5 && strcmp(path + length - 5, ".json") == 0;
 
-        } //if the line isn't a new section...
-        else {
-            ss[(int)type] << line << '\n';
-        }
-    }
-
-    return { ss[0].str(), ss[1].str() };
+    std::ofstream stream(path);
+    GLCallProfileDump(stream, json ? GLCallProfileFormat::JSON : GLCallProfileFormat::CSV);
 }
 
-
-static unsigned int CompileShader(unsigned int type, const std::string& source)
+int main(int argc, char** argv)
 {
-    unsigned int id = glCreateShader(type);
-    const char* src = source.c_str(); //we get the text of the shader in C-Style string
-
-    GLCall(glShaderSource(
-        id,     //id of the shader
-        1,      //num of sources in the string ??
-        &src,   //address of the pointer that points to the C-Style string.
-        nullptr //the length or nullptr to the end.
-    ));
-
-    GLCall(glCompileShader(id));
-
-    int result;
-
-    GLCall(glGetShaderiv(
-        id,                 //shader id.
-        GL_COMPILE_STATUS,  //we query whether the compilation was successful.
-        &result             //we store the result here.
-    ));
-
-    //if compilation wasn't successful...
-    if (result == GL_FALSE) {
-        int length;
-
-        GLCall(glGetShaderiv(  //we query the lenght of the message that contains info about the status
-            id,                 //shader id.
-            GL_INFO_LOG_LENGTH, //we query the length of the message.
-            &length             //we store the length here.
-        ));
-
-        //we make room in the stack for an array of characters to store the error message.
-        char* message = (char*)_malloca(length * sizeof(char)); //it allocates memory in the stack
-
-        //we get the error message
-        GLCall(glGetShaderInfoLog(
-            id,         //shader id
-            length,     //we give the size of the buffer (in case we have another size)
-            &length,    //we get the size of the message
-            message     //the message is set in the buffer.
-        ));
-
-        std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader!" << std::endl;
-        std::cout << message << std::endl;
-
-        GLCall(glDeleteShader(id)); //we delete this faulty shader.
-        return 0;
+    bool headless = false;  //--headless renders into an FBO without any window system
+    long frames = 0;        //--frames N renders N frames, prints the frame rate and quits. 0 means until the window is closed
+    const char* benchmark = nullptr; //--bench NAME runs one of the benchmarks in Benchmark.cpp headless
+    const char* glProfile = nullptr; //--gl-profile FILE writes the GLCall profile (GLCALL_PROFILE builds) at shutdown
+    const char* shaderCache = "shadercache"; //--shader-cache DIR keeps linked programs there, --no-shader-cache turns it off
+    bool hotReload = true;  //--no-hot-reload stops watching the shader files
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frames = strtol(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            benchmark = argv[++i];
+            headless = true;
+        }
+        else if (strcmp(argv[i], "--gl-profile") == 0 && i + 1 < argc) {
+            glProfile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--shader-cache") == 0 && i + 1 < argc) {
+            shaderCache = argv[++i];
+        }
+        else if (strcmp(argv[i], "--no-shader-cache") == 0) {
+            shaderCache = "";
+        }
+        else if (strcmp(argv[i], "--no-hot-reload") == 0) {
+            hotReload = false;
+        }
     }
 
-    return id;
-}
-
-/*
-* This function gets the vertex and fragment shaders in text format and compiles and link them together
-*/
-static unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader)
-{
-    unsigned int program = glCreateProgram();
-
-    //like compiling a C++ program
-    GLuint vs = CompileShader(GL_VERTEX_SHADER, vertexShader); //GLuint is a typedef of unsigned int
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    //without a window nobody can close it, so we always stop after some frames.
+    if (headless && frames <= 0) {
+        frames = 1000;
+    }
 
-    //like linking a C++ program
-    GLCall(glAttachShader(program, vs));
-    GLCall(glAttachShader(program, fs));
+    GLFWwindow* window = nullptr;
+    HeadlessContext headlessContext;
 
-    GLCall(glLinkProgram(program));
-    GLCall(glValidateProgram(program));
+    if (headless) {
+        if (!headlessContext.Create(640, 480)) {
+            return -1;
+        }
+    }
+    else {
+        /* Initialize the library */
+        if (!glfwInit()) {
+            return -1;
+        }
 
-    //removing the intermediate resources, like Obj files ??
-    GLCall(glDeleteShader(vs));
-    GLCall(glDeleteShader(fs));
+        //we create an OpenGL 3.3 Core profile through glfw facilities. (this has to be set before glfwCreateWindow)
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        //glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if GLCALL_MODE == GLCALL_MODE_DEBUG_OUTPUT
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
+
+        /* Create a windowed mode window and its OpenGL context */
+        window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);
+        if (!window)
+        {
+            glfwTerminate();
+            return -1;
+        }
 
-    return program;
-}
+        /* Make the window's context current */
+        glfwMakeContextCurrent(window);
 
-int main(void)
-{
-    GLFWwindow* window;
+        glfwSwapInterval(1);
+    }
 
-    /* Initialize the library */
-    if (!glfwInit()) {
-        return -1;
+    //Here we are initialising glew
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    //GLEW built for GLX complains about the missing X display with EGL, but the GL entry points are loaded anyway.
+    if (headless && glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) {
+        glewStatus = GLEW_OK;
+    }
+#endif
+    if (glewStatus != GLEW_OK) {
+        std::cout << "Error!" << std::endl;
     }
 
-    //we create an OpenGL 3.3 Core profile through glfw facilities. (this has to be set before glfwCreateWindow)
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    //glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    std::cout << glGetString(GL_VERSION) << std::endl;
 
-    /* Create a windowed mode window and its OpenGL context */
-    window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);
-    if (!window)
-    {
-        glfwTerminate();
+    GLInitDebugOutput();
+    ProgramCache::SetDirectory(shaderCache);
+
+    if (headless && !headlessContext.CreateFramebuffer()) {
         return -1;
     }
 
-    /* Make the window's context current */
-    glfwMakeContextCurrent(window);
+    if (benchmark) {
+        int result = RunBenchmark(benchmark, headlessContext, frames);
 
-    glfwSwapInterval(1);
-
-    //Here we are initialising glew
-    if (glewInit() != GLEW_OK) {
-        std::cout << "Error!" << std::endl;
+        if (glProfile) {
+            WriteGLCallProfile(glProfile);
+        }
+        return result;
     }
 
-    std::cout << glGetString(GL_VERSION) << std::endl;
-
     { //this is a scope to fix an OpenGL error for with the application doesn't terminate when closing the window.
+        //the driver compiles the shader while we set up the buffers.
+        ShaderQueue shaders;
+        ShaderQueue::Handle basic = shaders.Add("res/shaders/Basic.shader");
+
         float positions[] = {
             -.5f, -.5f, //vertex 0
             .5f, -.5f,  //vertex 1
@@ -183,68 +162,80 @@ int main(void)
 
 
         //in OpenGL 3.0+ Core we need to set up a vertex array.
-        unsigned int vao;
-        GLCall(glGenVertexArrays(1, &vao));
-        GLCall(glBindVertexArray(vao));
-
+        VertexArray va;
         VertexBuffer vb(positions, 4 * 2 * sizeof(float));
 
-        GLCall(glEnableVertexAttribArray(0));
-
-        //this command links the buffer with the vertex array
-        GLCall(glVertexAttribPointer(
-            0, //index to the first attribute
-            2, //num of elements that represents a vertex.
-            GL_FLOAT, //the type of the attributes. it's float in this case
-            GL_FALSE, //whether we need to normalize them. They are normalized already.
-            2 * sizeof(float), //size of the stride, number of bytes each vertex takes,
-            0 //pointer inside the vertex
-        ));
+        //this links the buffer with the vertex array. Every vertex is just a Vec2, the stride and the
+        //attribute format come from the layout at compile time.
+        va.AddBuffer<VertexBufferLayout<Vec2, Vec2>>(vb);
 
         IndexBuffer ib(indices, 6);
+        va.SetIndexBuffer(ib);
 
-        ShaderProgramSource source = ParseShader("res/shaders/Basic.shader");
+        //now we need it. Finishing looks up all its uniforms once.
+        Shader& shader = shaders.Wait(basic);
 
-        //we create the shader by providing the two programs to our function
-        unsigned int shader = CreateShader(source.VertexSource, source.FragmentSource);
+        //saving the file swaps the new program in, or prints why it didn't compile and keeps this one.
+        std::unique_ptr<ShaderWatcher> watcher;
+        if (hotReload) {
+            watcher.reset(new ShaderWatcher());
+            watcher->Watch(shader);
+        }
 
         //we select the program. this is because we could have some different programs.
-        GLCall(glUseProgram(shader));
+        shader.Bind();
 
-        //we retrieve the id of the uniform inside the shader program
-        GLCall(int location = glGetUniformLocation(shader, "u_Color"));
-        ASSERT(location != -1); //if it wasn't present we notify as error.
-        GLCall(glUniform4f(location, 0.8f, 0.3f, 0.8f, 1.0f));  //we set this color to send it to the fragment through the uniform.
+        ASSERT(shader.GetUniformLocation("u_Color") != -1); //if it wasn't present we notify as error.
+        shader.SetUniform4f("u_Color", 0.8f, 0.3f, 0.8f, 1.0f);  //we set this color to send it to the fragment through the uniform.
 
         //for the purpose of the demostration we unbind everything to do this where it corresponds.
-        GLCall(glBindVertexArray(0));
-        GLCall(glUseProgram(0));                            //we unbind the program
-        GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));           //we unbind the array buffer
-        GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));   //we unbind the index buffer
+        va.UnBind();
+        shader.UnBind();                                    //we unbind the program
+        vb.UnBind();                                        //we unbind the array buffer
+        ib.UnBind();                                        //we unbind the index buffer
 
 
 
         float r = 0.0f;
         float increment = 0.05f;
-        /* Loop until the user closes the window */
-        while (!glfwWindowShouldClose(window))
+        long frame = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        GpuProfiler profiler;
+
+        /* Loop until the user closes the window or we have rendered the frames we were asked for */
+        while (frames > 0 ? frame < frames : !glfwWindowShouldClose(window))
         {
+            profiler.BeginFrame();
+            int frameZone = profiler.BeginZone("Frame");
+
+            //a reloaded shader is swapped in here, before it is bound.
+            if (watcher) {
+                watcher->Update();
+            }
+
             /* Render here */
-            GLCall(glClear(GL_COLOR_BUFFER_BIT));
+            {
+                GpuZone zone(profiler, "Clear");
+                GLCall(glClear(GL_COLOR_BUFFER_BIT));
+            }
 
-            GLCall(glUseProgram(shader));                       //we bind the program
-            GLCall(glUniform4f(location, r, 0.3f, 0.8f, 1.0f)); //we now can set the uniform
+            shader.Bind();                                      //we bind the program. It only reaches the driver if it changed
+            shader.SetUniform4f("u_Color", r, 0.3f, 0.8f, 1.0f); //we now can set the uniform, the location comes from the shader's table
 
-            GLCall(glBindVertexArray(vao));                     //we bind vertex array
+            va.Bind();                                          //we bind vertex array
 
             ib.Bind();
 
-            GLCall(glDrawElements(
-                GL_TRIANGLES,       //what we can draw with the data. In this case triangles
-                6,                  //number of elements in the index array
-                GL_UNSIGNED_INT,         //type of the array
-                nullptr             //because it's in memory already we just put nullptr, otherwise the array of elements
-            ));
+            {
+                GpuZone zone(profiler, "Draw");
+                GLCall(glDrawElements(
+                    GL_TRIANGLES,       //what we can draw with the data. In this case triangles
+                    ib.GetCount(),      //number of elements in the index array
+                    ib.GetType(),       //type of the array. The index buffer picks the smallest one that fits
+                    nullptr             //because it's in memory already we just put nullptr, otherwise the array of elements
+                ));
+            }
 
             if (r > 1.0f) {
                 increment = -0.05f;
@@ -255,16 +246,47 @@ int main(void)
 
             r += increment;
 
-            /* Swap front and back buffers */
-            glfwSwapBuffers(window);
+            profiler.EndZone(frameZone);
+            profiler.EndFrame();
+
+            if (headless) {
+                headlessContext.SwapBuffers();
+            }
+            else {
+                /* Swap front and back buffers */
+                glfwSwapBuffers(window);
+
+                /* Poll for and process events */
+                glfwPollEvents();
+            }
+
+            frame++;
+        }
+
+        if (frames > 0) {
+            //we wait for the GPU to finish the queued frames so they count in the time.
+            GLCall(glFinish());
+
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "GLCall mode: " << GLCallModeName() << std::endl;
+            std::cout << "Rendered " << frame << " frames in " << seconds << " s: "
+                << frame / seconds << " fps ("
+                << seconds * 1000.0 / frame << " ms/frame)" << std::endl;
+            profiler.Print(std::cout);
 
-            /* Poll for and process events */
-            glfwPollEvents();
+            GLState::Stats stateStats = GLState::GetStats();
+            std::cout << "GL state: " << stateStats.issued << " calls issued, "
+                << stateStats.skipped << " redundant calls skipped" << std::endl;
         }
 
-        glDeleteProgram(shader);
     } //this is a scope to fix an OpenGL error for with the application doesn't terminate when closing the window.
 
-    glfwTerminate();
+    if (glProfile) {
+        WriteGLCallProfile(glProfile);
+    }
+
+    if (!headless) {
+        glfwTerminate();
+    }
     return 0;
 }
\ No newline at end of file
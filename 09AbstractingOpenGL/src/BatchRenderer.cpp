@@ -0,0 +1,144 @@
+#include "BatchRenderer.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "Shader.h"
+
+#include <cstddef>
+
+//the indices of every quad: two triangles sharing the diagonal, like the quad in Application.cpp.
+static std::vector<unsigned int> GenerateQuadIndices(unsigned int maxQuads)
+{
+    std::vector<unsigned int> indices(maxQuads * 6);
+    for (unsigned int quad = 0; quad < maxQuads; quad++) {
+        unsigned int vertex = quad * 4;
+        indices[quad * 6 + 0] = vertex + 0;
+        indices[quad * 6 + 1] = vertex + 1;
+        indices[quad * 6 + 2] = vertex + 2;
+        indices[quad * 6 + 3] = vertex + 2;
+        indices[quad * 6 + 4] = vertex + 3;
+        indices[quad * 6 + 5] = vertex + 0;
+    }
+    return indices;
+}
+
+BatchRenderer::BatchRenderer(Shader& shader, unsigned int maxQuads)
+    : m_MaxQuads(maxQuads),
+      m_Vertices(maxQuads * 4),
+      m_QuadCount(0),
+      m_VertexBuffer(nullptr, maxQuads * 4 * sizeof(Vertex), BufferStrategy::Orphan),
+      m_IndexBuffer(GenerateQuadIndices(maxQuads).data(), maxQuads * 6),
+      m_Shader(&shader),
+      m_TextureSlotCount(1)
+{
+    ResetStats();
+
+    m_VertexArray.AddBuffer<Vertex::Layout>(m_VertexBuffer);
+    m_VertexArray.SetIndexBuffer(m_IndexBuffer);
+
+    //a 1x1 white texture so coloured quads go through the same shader as textured ones.
+    unsigned int white = 0xFFFFFFFF;
+    GLCall(glGenTextures(1, &m_WhiteTexture));
+    GLState::BindTexture(0, GL_TEXTURE_2D, m_WhiteTexture);
+    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+
+    m_TextureSlots[0] = m_WhiteTexture;
+    for (unsigned int i = 1; i < MaxTextureSlots; i++) {
+        m_TextureSlots[i] = 0;
+    }
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    GLState::DeleteTexture(m_WhiteTexture);
+}
+
+void BatchRenderer::Begin()
+{
+    m_QuadCount = 0;
+    m_TextureSlotCount = 1;
+}
+
+void BatchRenderer::End()
+{
+    Flush(Explicit);
+}
+
+void BatchRenderer::SetShader(Shader& shader)
+{
+    if (&shader != m_Shader) {
+        Flush(Explicit);
+        m_Shader = &shader;
+    }
+}
+
+float BatchRenderer::GetTextureSlot(unsigned int texture)
+{
+    if (texture == 0) {
+        return 0.0f;
+    }
+
+    for (unsigned int slot = 1; slot < m_TextureSlotCount; slot++) {
+        if (m_TextureSlots[slot] == texture) {
+            return (float)slot;
+        }
+    }
+
+    if (m_TextureSlotCount == MaxTextureSlots) {
+        Flush(OutOfTextureSlots);
+    }
+
+    m_TextureSlots[m_TextureSlotCount] = texture;
+    return (float)m_TextureSlotCount++;
+}
+
+void BatchRenderer::DrawQuad(const Vec2& position, const Vec2& size, const Vec4& color, unsigned int texture)
+{
+    if (m_QuadCount == m_MaxQuads) {
+        Flush(Full);
+    }
+
+    float slot = GetTextureSlot(texture);
+
+    Vertex* vertex = &m_Vertices[m_QuadCount * 4];
+    vertex[0] = { { position.x, position.y }, color, { 0.0f, 0.0f }, slot };
+    vertex[1] = { { position.x + size.x, position.y }, color, { 1.0f, 0.0f }, slot };
+    vertex[2] = { { position.x + size.x, position.y + size.y }, color, { 1.0f, 1.0f }, slot };
+    vertex[3] = { { position.x, position.y + size.y }, color, { 0.0f, 1.0f }, slot };
+
+    m_QuadCount++;
+}
+
+void BatchRenderer::Flush(FlushReason reason)
+{
+    if (m_QuadCount == 0) {
+        return;
+    }
+
+    m_VertexBuffer.Update(0, m_Vertices.data(), m_QuadCount * 4 * sizeof(Vertex));
+
+    m_Shader->Bind();
+    for (unsigned int slot = 0; slot < m_TextureSlotCount; slot++) {
+        GLState::BindTexture(slot, GL_TEXTURE_2D, m_TextureSlots[slot]);
+    }
+
+    //the sampler array always maps slot i to unit i.
+    static const int units[MaxTextureSlots] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    m_Shader->SetUniform1iv("u_Textures", MaxTextureSlots, units);
+
+    m_VertexArray.Bind();
+    GLCall(glDrawElements(GL_TRIANGLES, m_QuadCount * 6, m_IndexBuffer.GetType(), nullptr));
+
+    m_Stats.DrawCalls++;
+    m_Stats.Quads += m_QuadCount;
+    m_Stats.Flushes[reason]++;
+
+    m_QuadCount = 0;
+    m_TextureSlotCount = 1;
+}
+
+void BatchRenderer::ResetStats()
+{
+    m_Stats = { 0, 0, { 0, 0, 0 } };
+}
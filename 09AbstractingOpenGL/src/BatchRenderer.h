@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Math.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+
+#include <vector>
+
+class Shader;
+
+/*
+* Collects quads on the CPU and draws as many of them as fit in the vertex buffer with a single
+* glDrawElements. It flushes when the buffer is full, when it runs out of texture slots or when
+* the shader changes.
+*
+*   batch.Begin();
+*   batch.DrawQuad(...);    //as many as you like
+*   batch.End();
+*/
+class BatchRenderer
+{
+public:
+	static const unsigned int MaxTextureSlots = 16; //must match u_Textures in Batch.shader
+
+	struct Vertex
+	{
+		Vec2 Position;
+		Vec4 Color;
+		Vec2 TexCoord;
+		float TexIndex;
+
+		using Layout = VertexBufferLayout<Vertex, Vec2, Vec4, Vec2, float>;
+	};
+
+	struct Stats
+	{
+		unsigned int DrawCalls;
+		unsigned int Quads;
+		unsigned int Flushes[3]; //why we flushed: buffer full, out of texture slots, explicit (End, SetShader)
+
+		inline float QuadsPerDrawCall() const { return DrawCalls ? (float)Quads / DrawCalls : 0.0f; }
+	};
+private:
+	unsigned int m_MaxQuads;
+	std::vector<Vertex> m_Vertices;		//CPU copy of the batch being built
+	unsigned int m_QuadCount;
+
+	VertexBuffer m_VertexBuffer;		//orphaned on every flush
+	IndexBuffer m_IndexBuffer;			//the same 6 indices per quad, generated once
+	VertexArray m_VertexArray;
+
+	Shader* m_Shader;
+	unsigned int m_WhiteTexture;		//slot 0, so untextured quads can share the shader
+	unsigned int m_TextureSlots[MaxTextureSlots];
+	unsigned int m_TextureSlotCount;
+
+	Stats m_Stats;
+
+	enum FlushReason { Full = 0, OutOfTextureSlots = 1, Explicit = 2 };
+	void Flush(FlushReason reason);
+	float GetTextureSlot(unsigned int texture);
+public:
+	BatchRenderer(Shader& shader, unsigned int maxQuads = 16384); //16384 quads is the most that keeps 16 bit indices
+	~BatchRenderer();
+
+	void Begin();
+	void End();
+
+	//texture 0 means a plain coloured quad. position is the bottom left corner.
+	void DrawQuad(const Vec2& position, const Vec2& size, const Vec4& color, unsigned int texture = 0);
+
+	//flushes the pending quads if the shader is different
+	void SetShader(Shader& shader);
+
+	inline const Stats& GetStats() const { return m_Stats; }
+	void ResetStats();
+};
@@ -0,0 +1,1556 @@
+#include "Benchmark.h"
+#include "Renderer.h"
+#include "HeadlessContext.h"
+#include "Shader.h"
+#include "VertexBuffer.h"
+#include "VertexArray.h"
+#include "GLState.h"
+#include "BatchRenderer.h"
+#include "IndexBuffer.h"
+#include "MeshOptimizer.h"
+#include "VertexPacking.h"
+#include "Meshlets.h"
+#include "Frustum.h"
+#include "IndirectCommandBuffer.h"
+#include "FrustumCuller.h"
+#include "ThreadPool.h"
+#include "ProgramCache.h"
+#include "ShaderQueue.h"
+#include "ShaderWatcher.h"
+#include "ShaderVariants.h"
+#include "BufferPool.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <random>
+#include <filesystem>
+#include <memory>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+#include <sstream>
+
+double FrameStats::Average() const
+{
+    if (m_Samples.empty()) {
+        return 0.0;
+    }
+
+    double total = 0.0;
+    for (double sample : m_Samples) {
+        total += sample;
+    }
+    return total / m_Samples.size();
+}
+
+double FrameStats::Percentile(double p) const
+{
+    if (m_Samples.empty()) {
+        return 0.0;
+    }
+
+    std::vector<double> sorted(m_Samples);
+    size_t index = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+void FrameStats::Print(const char* label) const
+{
+    std::cout << label << ": avg " << Average() << " ms, p50 " << Percentile(50.0)
+        << " ms, p99 " << Percentile(99.0) << " ms (" << m_Samples.size() << " frames)" << std::endl;
+}
+
+/*
+* Issues a lot of cheap wrapped GL calls per frame so the cost of the GLCall mode dominates.
+* Build once per GLCALL_MODE and compare the output.
+*/
+static int BenchmarkGLCall(HeadlessContext& context, long frames)
+{
+    const int callsPerFrame = 2000;
+
+    unsigned int buffers[2];
+    GLCall(glGenBuffers(2, buffers));
+
+    FrameStats stats;
+    auto start = std::chrono::steady_clock::now();
+
+    for (long frame = 0; frame < frames; frame++) {
+        auto frameStart = std::chrono::steady_clock::now();
+
+        GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+        for (int i = 0; i < callsPerFrame; i += 2) {
+            GLCall(glBindBuffer(GL_ARRAY_BUFFER, buffers[i & 2 ? 1 : 0]));
+            GLCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+        }
+
+        context.SwapBuffers();
+        stats.Add(MillisecondsSince(frameStart));
+    }
+
+    GLCall(glFinish());
+    double total = MillisecondsSince(start);
+
+    std::cout << "GLCall mode: " << GLCallModeName() << ", " << callsPerFrame << " calls per frame" << std::endl;
+    stats.Print("CPU frame time");
+    std::cout << "Total " << total << " ms, " << total / frames << " ms/frame" << std::endl;
+
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    GLCall(glDeleteBuffers(2, buffers));
+    return 0;
+}
+
+/*
+* Thousands of uniform updates per frame: through the Shader's location table and,
+* for comparison, asking the driver for the location every time.
+*/
+static int BenchmarkUniforms(HeadlessContext& context, long frames)
+{
+    const int setsPerFrame = 5000;
+
+    Shader shader("res/shaders/Basic.shader");
+    shader.Bind();
+
+    FrameStats cached;
+    for (long frame = 0; frame < frames; frame++) {
+        auto frameStart = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < setsPerFrame; i++) {
+            shader.SetUniform4f("u_Color", (float)i / setsPerFrame, 0.3f, 0.8f, 1.0f);
+        }
+
+        context.SwapBuffers();
+        cached.Add(MillisecondsSince(frameStart));
+    }
+    GLCall(glFinish());
+
+    FrameStats lookedUp;
+    unsigned int program = shader.GetRendererID();
+    for (long frame = 0; frame < frames; frame++) {
+        auto frameStart = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < setsPerFrame; i++) {
+            int location = GLCallValue(glGetUniformLocation(program, "u_Color"));
+            GLCall(glUniform4f(location, (float)i / setsPerFrame, 0.3f, 0.8f, 1.0f));
+        }
+
+        context.SwapBuffers();
+        lookedUp.Add(MillisecondsSince(frameStart));
+    }
+    GLCall(glFinish());
+
+    std::cout << setsPerFrame << " uniform sets per frame, GLCall mode: " << GLCallModeName() << std::endl;
+    cached.Print("Shader::SetUniform4f");
+    lookedUp.Print("glGetUniformLocation + glUniform4f");
+    return 0;
+}
+
+/*
+* Rewrites a whole VertexBuffer every frame with each update strategy, for sizes from 1 KB to 64 MB.
+* Every frame also draws a point sourced from the buffer so the GPU really depends on the upload.
+*/
+static int BenchmarkUploads(HeadlessContext& context, long frames)
+{
+    const BufferStrategy strategies[] = {
+        BufferStrategy::SubData,
+        BufferStrategy::Orphan,
+        BufferStrategy::MapUnsynchronized,
+        BufferStrategy::Persistent
+    };
+
+    Shader shader("res/shaders/Basic.shader");
+    shader.Bind();
+    shader.SetUniform4f("u_Color", 1.0f, 1.0f, 1.0f, 1.0f);
+
+    VertexArray va;
+
+    std::vector<unsigned char> source(64 << 20);
+    for (size_t i = 0; i < source.size(); i++) {
+        source[i] = (unsigned char)i;
+    }
+
+    std::cout << "strategy, size KB, MB/s, avg ms/frame, p99 ms/frame" << std::endl;
+
+    for (BufferStrategy strategy : strategies) {
+        for (unsigned int size = 1 << 10; size <= (64u << 20); size <<= 2) {
+            VertexBuffer vb(source.data(), size, strategy);
+
+            va.AddBuffer<VertexBufferLayout<Vec2, Vec2>>(vb, 0, 0); //every buffer goes to location 0
+
+            //big uploads get fewer frames so the whole run stays short.
+            long iterations = std::max(8L, std::min(frames, (long)((256u << 20) / size)));
+
+            auto uploadFrame = [&]() {
+                vb.BeginFrame();
+                vb.Update(0, source.data(), size);
+                GLCall(glDrawArrays(GL_POINTS, vb.GetFrameOffset() / (2 * sizeof(float)), 1));
+                vb.EndFrame();
+
+                context.SwapBuffers();
+            };
+
+            //the first upload of a buffer pays for the driver setting it up, it isn't counted.
+            uploadFrame();
+            GLCall(glFinish());
+
+            FrameStats stats;
+            auto start = std::chrono::steady_clock::now();
+
+            for (long frame = 0; frame < iterations; frame++) {
+                auto frameStart = std::chrono::steady_clock::now();
+                uploadFrame();
+                stats.Add(MillisecondsSince(frameStart));
+            }
+
+            GLCall(glFinish());
+            double seconds = MillisecondsSince(start) / 1000.0;
+
+            std::cout << BufferStrategyName(strategy) << ", " << (size >> 10) << ", "
+                << (double)size * iterations / (1 << 20) / seconds << ", "
+                << stats.Average() << ", " << stats.Percentile(99.0) << std::endl;
+        }
+    }
+
+    return 0;
+}
+
+/*
+* 100k quads per frame through the BatchRenderer: first plain coloured ones, then textured ones
+* using more textures than there are slots, grouped by texture like a sorted scene would be.
+*/
+static int BenchmarkBatch(HeadlessContext& context, long frames)
+{
+    const unsigned int columns = 400;
+    const unsigned int rows = 250;
+    const unsigned int textureCount = 24;
+
+    Shader shader("res/shaders/Batch.shader");
+    BatchRenderer batch(shader);
+
+    unsigned int textures[textureCount];
+    GLCall(glGenTextures(textureCount, textures));
+    for (unsigned int i = 0; i < textureCount; i++) {
+        unsigned int texel = 0xFF000000 | (i * 0x0A0B0C);
+        GLState::BindTexture(0, GL_TEXTURE_2D, textures[i]);
+        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &texel));
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    }
+
+    const Vec2 size = { 2.0f / columns, 2.0f / rows };
+
+    for (int textured = 0; textured < 2; textured++) {
+        FrameStats stats;
+        batch.ResetStats();
+
+        for (long frame = 0; frame < frames; frame++) {
+            auto frameStart = std::chrono::steady_clock::now();
+
+            GLCall(glClear(GL_COLOR_BUFFER_BIT));
+            batch.Begin();
+            for (unsigned int y = 0; y < rows; y++) {
+                for (unsigned int x = 0; x < columns; x++) {
+                    unsigned int quad = y * columns + x;
+                    Vec2 position = { -1.0f + x * size.x, -1.0f + y * size.y };
+                    Vec4 color = { (float)x / columns, (float)y / rows, 0.5f, 1.0f };
+                    batch.DrawQuad(position, size, color, textured ? textures[quad * textureCount / (columns * rows)] : 0);
+                }
+            }
+            batch.End();
+
+            context.SwapBuffers();
+            stats.Add(MillisecondsSince(frameStart));
+        }
+        GLCall(glFinish());
+
+        const BatchRenderer::Stats& batchStats = batch.GetStats();
+        std::cout << (textured ? "Textured" : "Coloured") << ": " << columns * rows << " quads per frame, "
+            << (double)batchStats.DrawCalls / frames << " draw calls per frame, "
+            << batchStats.QuadsPerDrawCall() << " quads per flush (flushes: "
+            << batchStats.Flushes[0] << " full, " << batchStats.Flushes[1] << " texture slots, "
+            << batchStats.Flushes[2] << " explicit)" << std::endl;
+        stats.Print("CPU frame time");
+    }
+
+    for (unsigned int texture : textures) {
+        GLState::DeleteTexture(texture);
+    }
+    return 0;
+}
+
+/*
+* 1, 1k and 1M copies of a small quad: one instanced draw call against one glUniform + glDrawElements per copy.
+*/
+static int BenchmarkInstancing(HeadlessContext& context, long frames)
+{
+    struct Instance
+    {
+        Vec2 Offset;
+        Vec4 Color;
+
+        using Layout = VertexBufferLayout<Instance, Vec2, Vec4>;
+    };
+
+    const float positions[] = {
+        -.005f, -.005f,
+        .005f, -.005f,
+        .005f, .005f,
+        -.005f, .005f,
+    };
+    const unsigned int indices[] = {
+        0, 1, 2,
+        2, 3, 0
+    };
+
+    Renderer renderer;
+    Shader instancedShader("res/shaders/Instanced.shader");
+    Shader naiveShader("res/shaders/Offset.shader");
+    IndexBuffer ib(indices, 6);
+    VertexBuffer quad(positions, sizeof(positions));
+
+    for (unsigned int count : { 1u, 1000u, 1000000u }) {
+        std::vector<Instance> instances(count);
+        for (unsigned int i = 0; i < count; i++) {
+            float x = (float)(i % 1000) / 500.0f - 1.0f;
+            float y = (float)(i / 1000) / 500.0f - 1.0f;
+            instances[i] = { { x, y }, { x * 0.5f + 0.5f, y * 0.5f + 0.5f, 0.5f, 1.0f } };
+        }
+
+        VertexBuffer instanceBuffer(instances.data(), count * sizeof(Instance));
+
+        VertexArray va;
+        va.AddBuffer<VertexBufferLayout<Vec2, Vec2>>(quad);    //location 0
+        va.AddBuffer<Instance::Layout>(instanceBuffer, 1);      //locations 1 and 2, once per instance
+        va.SetIndexBuffer(ib);
+
+        FrameStats instanced;
+        for (long frame = 0; frame < frames; frame++) {
+            auto frameStart = std::chrono::steady_clock::now();
+
+            renderer.Clear();
+            renderer.DrawInstanced(va, ib, instancedShader, count);
+
+            context.SwapBuffers();
+            instanced.Add(MillisecondsSince(frameStart));
+        }
+        GLCall(glFinish());
+
+        //the same picture with a draw call per copy. A million draws take a while, so fewer frames.
+        long naiveFrames = std::max(1L, std::min(frames, (long)(1000000 / count)));
+        FrameStats naive;
+        for (long frame = 0; frame < naiveFrames; frame++) {
+            auto frameStart = std::chrono::steady_clock::now();
+
+            renderer.Clear();
+            for (const Instance& instance : instances) {
+                naiveShader.Bind();
+                naiveShader.SetUniform2f("u_Offset", instance.Offset.x, instance.Offset.y);
+                naiveShader.SetUniform4f("u_Color", instance.Color.x, instance.Color.y, instance.Color.z, instance.Color.w);
+                renderer.Draw(va, ib, naiveShader);
+            }
+
+            context.SwapBuffers();
+            naive.Add(MillisecondsSince(frameStart));
+        }
+        GLCall(glFinish());
+
+        std::cout << count << " instances" << std::endl;
+        instanced.Print("  DrawInstanced");
+        naive.Print("  per-instance draws");
+    }
+    return 0;
+}
+
+/*
+* A bumpy grid of about 100k and 10M triangles in shuffled order, before and after OptimizeMesh:
+* ACMR/ATVR, how long each pass takes and how long the GPU takes to draw it.
+*/
+static int BenchmarkMeshOptimizer(HeadlessContext& context, long frames)
+{
+    Renderer renderer;
+    Shader shader("res/shaders/Basic.shader");
+    shader.Bind();
+    shader.SetUniform4f("u_Color", 1.0f, 1.0f, 1.0f, 1.0f);
+
+    //drawing 10M triangles is slow without a real GPU, a few frames are enough.
+    long drawFrames = std::max(1L, std::min(frames, 10L));
+
+    for (unsigned int side : { 224u, 2236u }) {
+        std::vector<Vec3> vertices((side + 1) * (side + 1));
+        for (unsigned int y = 0; y <= side; y++) {
+            for (unsigned int x = 0; x <= side; x++) {
+                float u = (float)x / side * 2.0f - 1.0f;
+                float v = (float)y / side * 2.0f - 1.0f;
+                vertices[y * (side + 1) + x] = { u, v, 0.1f * std::sin(u * 20.0f) * std::cos(v * 20.0f) };
+            }
+        }
+
+        std::vector<unsigned int> triangles;
+        triangles.reserve(side * side * 2);
+        for (unsigned int i = 0; i < side * side * 2; i++) {
+            triangles.push_back(i);
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+
+        //the grid triangles in the shuffled order, that's what a badly exported mesh looks like to the GPU.
+        std::vector<unsigned int> indices(triangles.size() * 3);
+        for (size_t i = 0; i < triangles.size(); i++) {
+            unsigned int quad = triangles[i] / 2;
+            unsigned int v0 = quad / side * (side + 1) + quad % side;
+            unsigned int quadIndices[2][3] = {
+                { v0, v0 + 1, v0 + side + 2 },
+                { v0 + side + 2, v0 + side + 1, v0 }
+            };
+            memcpy(&indices[i * 3], quadIndices[triangles[i] % 2], 3 * sizeof(unsigned int));
+        }
+
+        auto draw = [&](const char* label) {
+            VertexArray va;
+            VertexBuffer vb(vertices.data(), (unsigned int)(vertices.size() * sizeof(Vec3)));
+            va.AddBuffer<VertexBufferLayout<Vec3, Vec3>>(vb);
+            IndexBuffer ib(indices.data(), (unsigned int)indices.size());
+            va.SetIndexBuffer(ib);
+
+            FrameStats stats;
+            for (long frame = 0; frame < drawFrames; frame++) {
+                auto frameStart = std::chrono::steady_clock::now();
+
+                renderer.Clear();
+                renderer.Draw(va, ib, shader);
+                GLCall(glFinish());
+
+                stats.Add(MillisecondsSince(frameStart));
+            }
+            context.SwapBuffers();
+            stats.Print(label);
+        };
+
+        std::cout << indices.size() / 3 << " triangles" << std::endl;
+        draw("  shuffled draw");
+
+        MeshOptimizerReport report = OptimizeMesh(vertices.data(), vertices.size(), sizeof(Vec3), 0, 3,
+            indices.data(), indices.size());
+        vertices.resize(report.VertexCount);
+
+        std::cout << "  ACMR " << report.Before.ACMR << " -> " << report.After.ACMR
+            << ", ATVR " << report.Before.ATVR << " -> " << report.After.ATVR << std::endl;
+        std::cout << "  vertex cache " << report.CacheMilliseconds << " ms, overdraw "
+            << report.OverdrawMilliseconds << " ms, vertex fetch " << report.FetchMilliseconds << " ms" << std::endl;
+
+        draw("  optimized draw");
+    }
+    return 0;
+}
+
+/*
+* A 1M vertex grid with 64 byte float vertices against the same vertices packed to 24 bytes in five
+* streams with VertexPacking: how long packing takes, how long each version takes to draw and how
+* different the pictures are.
+*/
+static int BenchmarkPacking(HeadlessContext& context, long frames)
+{
+    struct MeshVertex
+    {
+        Vec3 Position;
+        Vec3 Normal;
+        Vec2 TexCoord;
+        Vec4 Color;
+        Vec4 Tangent;
+
+        using Layout = VertexBufferLayout<MeshVertex, Vec3, Vec3, Vec2, Vec4, Vec4>;
+    };
+
+    const unsigned int side = 1000;
+    const size_t vertexCount = (side + 1) * (side + 1);
+
+    std::vector<MeshVertex> vertices(vertexCount);
+    for (unsigned int y = 0; y <= side; y++) {
+        for (unsigned int x = 0; x <= side; x++) {
+            float u = (float)x / side;
+            float v = (float)y / side;
+            float nx = std::sin(u * 20.0f) * 0.5f;
+            float ny = std::cos(v * 20.0f) * 0.5f;
+            float length = std::sqrt(nx * nx + ny * ny + 1.0f);
+
+            vertices[y * (side + 1) + x] = {
+                { u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.0f },
+                { nx / length, ny / length, 1.0f / length },
+                { u, v },
+                { 0.5f + 0.5f * u, 0.5f, 1.0f - 0.5f * v, 1.0f },
+                { 1.0f, 0.0f, -nx / length, (x & 1) ? 1.0f : -1.0f }
+            };
+        }
+    }
+
+    std::vector<unsigned int> indices;
+    indices.reserve(side * side * 6);
+    for (unsigned int y = 0; y < side; y++) {
+        for (unsigned int x = 0; x < side; x++) {
+            unsigned int v0 = y * (side + 1) + x;
+            unsigned int quad[] = { v0, v0 + 1, v0 + side + 2, v0 + side + 2, v0 + side + 1, v0 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    //the packing stage: every attribute to its own stream in its compact format.
+    std::vector<Vec3> positions(vertexCount), normals(vertexCount);
+    std::vector<Vec2> texCoords(vertexCount);
+    std::vector<Vec4> colors(vertexCount), tangents(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++) {
+        positions[i] = vertices[i].Position;
+        normals[i] = vertices[i].Normal;
+        texCoords[i] = vertices[i].TexCoord;
+        colors[i] = vertices[i].Color;
+        tangents[i] = vertices[i].Tangent;
+    }
+
+    std::vector<Half<4>> packedPositions(vertexCount);
+    std::vector<Octahedral> packedNormals(vertexCount);
+    std::vector<Normalized<unsigned short, 2>> packedTexCoords(vertexCount);
+    std::vector<Normalized<unsigned char, 4>> packedColors(vertexCount);
+    std::vector<Snorm1010102> packedTangents(vertexCount);
+
+    auto start = std::chrono::steady_clock::now();
+    PackHalf(packedPositions[0].v, &positions[0].x, vertexCount, 3, 4);
+    PackOctahedral(packedNormals[0].v, normals.data(), vertexCount);
+    PackUnorm16(packedTexCoords[0].v, &texCoords[0].x, vertexCount * 2);
+    PackUnorm8(packedColors[0].v, &colors[0].x, vertexCount * 4);
+    PackSnorm1010102(&packedTangents[0].v, tangents.data(), vertexCount);
+    double packMilliseconds = MillisecondsSince(start);
+
+    const size_t packedSize = sizeof(Half<4>) + sizeof(Octahedral) + sizeof(Normalized<unsigned short, 2>)
+        + sizeof(Normalized<unsigned char, 4>) + sizeof(Snorm1010102);
+
+    Renderer renderer;
+    Shader floatShader("res/shaders/Mesh.shader");
+    Shader packedShader("res/shaders/MeshPacked.shader");
+    IndexBuffer ib(indices.data(), (unsigned int)indices.size());
+
+    VertexBuffer floatBuffer(vertices.data(), (unsigned int)(vertexCount * sizeof(MeshVertex)));
+    VertexArray floatArray;
+    floatArray.AddBuffer<MeshVertex::Layout>(floatBuffer);
+    floatArray.SetIndexBuffer(ib);
+
+    VertexBuffer positionBuffer(packedPositions.data(), (unsigned int)(vertexCount * sizeof(Half<4>)));
+    VertexBuffer normalBuffer(packedNormals.data(), (unsigned int)(vertexCount * sizeof(Octahedral)));
+    VertexBuffer texCoordBuffer(packedTexCoords.data(), (unsigned int)(vertexCount * sizeof(Normalized<unsigned short, 2>)));
+    VertexBuffer colorBuffer(packedColors.data(), (unsigned int)(vertexCount * sizeof(Normalized<unsigned char, 4>)));
+    VertexBuffer tangentBuffer(packedTangents.data(), (unsigned int)(vertexCount * sizeof(Snorm1010102)));
+
+    VertexArray packedArray;
+    packedArray.AddBuffer<VertexBufferLayout<Half<4>, Half<4>>>(positionBuffer);
+    packedArray.AddBuffer<VertexBufferLayout<Octahedral, Octahedral>>(normalBuffer);
+    packedArray.AddBuffer<VertexBufferLayout<Normalized<unsigned short, 2>, Normalized<unsigned short, 2>>>(texCoordBuffer);
+    packedArray.AddBuffer<VertexBufferLayout<Normalized<unsigned char, 4>, Normalized<unsigned char, 4>>>(colorBuffer);
+    packedArray.AddBuffer<VertexBufferLayout<Snorm1010102, Snorm1010102>>(tangentBuffer);
+    packedArray.SetIndexBuffer(ib);
+
+    const int width = 640, height = 480;
+    std::vector<unsigned char> floatPixels(width * height * 4), packedPixels(width * height * 4);
+
+    auto run = [&](const VertexArray& va, Shader& shader, std::vector<unsigned char>& pixels, const char* label) {
+        FrameStats stats;
+        for (long frame = 0; frame < frames; frame++) {
+            auto frameStart = std::chrono::steady_clock::now();
+
+            renderer.Clear();
+            renderer.Draw(va, ib, shader);
+            GLCall(glFinish());
+
+            stats.Add(MillisecondsSince(frameStart));
+        }
+        GLCall(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+        context.SwapBuffers();
+        stats.Print(label);
+    };
+
+    std::cout << vertexCount << " vertices: " << sizeof(MeshVertex) << " bytes each as floats, " << packedSize
+        << " packed (" << (float)sizeof(MeshVertex) / packedSize << "x smaller), packed in " << packMilliseconds << " ms" << std::endl;
+
+    run(floatArray, floatShader, floatPixels, "  float draw");
+    run(packedArray, packedShader, packedPixels, "  packed draw");
+
+    int maxDifference = 0;
+    for (size_t i = 0; i < floatPixels.size(); i++) {
+        maxDifference = std::max(maxDifference, std::abs((int)floatPixels[i] - (int)packedPixels[i]));
+    }
+    std::cout << "  largest channel difference between the pictures: " << maxDifference << "/255" << std::endl;
+    return 0;
+}
+
+/*
+* A 500k triangle sphere seen from close by, so half of it faces away and part of it is off screen:
+* drawing all of it against culling its meshlets and drawing the visible ones with one DrawIndirect.
+*/
+static int BenchmarkMeshlets(HeadlessContext& context, long frames)
+{
+    const unsigned int rings = 500;
+    const unsigned int segments = 500;
+    const float pi = 3.14159265f;
+
+    std::vector<Vec3> vertices;
+    for (unsigned int ring = 0; ring <= rings; ring++) {
+        for (unsigned int segment = 0; segment <= segments; segment++) {
+            float theta = pi * ring / rings;
+            float phi = 2.0f * pi * segment / segments;
+            vertices.push_back({ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+        }
+    }
+
+    std::vector<unsigned int> indices;
+    for (unsigned int ring = 0; ring < rings; ring++) {
+        for (unsigned int segment = 0; segment < segments; segment++) {
+            unsigned int v0 = ring * (segments + 1) + segment;
+            unsigned int quad[2][3] = {
+                { v0, v0 + segments + 1, v0 + segments + 2 },
+                { v0 + segments + 2, v0 + 1, v0 }
+            };
+
+            for (auto& triangle : quad) {
+                //outward facing, counter clockwise seen from outside
+                const Vec3& a = vertices[triangle[0]];
+                if (Dot(Cross(vertices[triangle[1]] - a, vertices[triangle[2]] - a), a) < 0.0f) {
+                    std::swap(triangle[1], triangle[2]);
+                }
+                indices.insert(indices.end(), triangle, triangle + 3);
+            }
+        }
+    }
+
+    std::vector<unsigned int> optimized(indices.size());
+    OptimizeVertexCache(optimized.data(), indices.data(), indices.size(), vertices.size());
+
+    auto start = std::chrono::steady_clock::now();
+    Meshlets meshlets(optimized.data(), optimized.size(), &vertices[0].x, vertices.size(), sizeof(Vec3), 3);
+    std::cout << optimized.size() / 3 << " triangles in " << meshlets.GetCount() << " meshlets, built in "
+        << MillisecondsSince(start) << " ms" << std::endl;
+
+    Vec3 camera = { 0.6f, 0.3f, 1.8f };
+    Mat4 viewProjection = Multiply(Perspective(1.0f, 640.0f / 480.0f, 0.1f, 100.0f), LookAt(camera, { 0.5f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }));
+    Frustum frustum = Frustum::FromMatrix(viewProjection);
+
+    Renderer renderer;
+    Shader shader("res/shaders/Transform.shader");
+    shader.Bind();
+    shader.SetUniformMat4f("u_ViewProjection", viewProjection.m);
+    shader.SetUniform4f("u_Color", 1.0f, 0.5f, 0.2f, 1.0f);
+
+    VertexArray va;
+    VertexBuffer vb(vertices.data(), (unsigned int)(vertices.size() * sizeof(Vec3)));
+    va.AddBuffer<VertexBufferLayout<Vec3, Vec3>>(vb);
+    IndexBuffer ib(optimized.data(), (unsigned int)optimized.size());
+    va.SetIndexBuffer(ib);
+
+    IndirectCommandBuffer commands;
+
+    const int width = 640, height = 480;
+    std::vector<unsigned char> allPixels(width * height * 4), culledPixels(width * height * 4);
+
+    FrameStats all;
+    for (long frame = 0; frame < frames; frame++) {
+        auto frameStart = std::chrono::steady_clock::now();
+
+        renderer.Clear();
+        renderer.Draw(va, ib, shader);
+        GLCall(glFinish());
+
+        all.Add(MillisecondsSince(frameStart));
+    }
+    GLCall(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, allPixels.data()));
+    context.SwapBuffers();
+
+    FrameStats culled, cullTime;
+    MeshletCullStats stats = {};
+    for (long frame = 0; frame < frames; frame++) {
+        auto frameStart = std::chrono::steady_clock::now();
+
+        renderer.Clear();
+        commands.Clear();
+        stats = meshlets.Cull(frustum, camera, commands);
+        cullTime.Add(MillisecondsSince(frameStart));
+
+        renderer.DrawIndirect(va, ib, shader, commands);
+        GLCall(glFinish());
+
+        culled.Add(MillisecondsSince(frameStart));
+    }
+    GLCall(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, culledPixels.data()));
+    context.SwapBuffers();
+
+    std::cout << stats.Visible << " visible, " << stats.OutsideFrustum << " outside the frustum, " << stats.BackFacing
+        << " back facing, drawn with " << stats.Commands << " commands" << std::endl;
+    all.Print("  everything");
+    cullTime.Print("  culling pass");
+    culled.Print("  culled (pass + draw)");
+    std::cout << "  same picture: " << (allPixels == culledPixels ? "yes" : "no") << std::endl;
+    return 0;
+}
+
+/*
+* 200k cubes scattered around a turning camera. Every frame we cull their boxes with FrustumCuller,
+* copy the visible ones to the instance buffer and draw them with one DrawInstanced, against
+* drawing all of them every frame.
+*/
+static int BenchmarkCulling(HeadlessContext& context, long frames)
+{
+    struct Instance
+    {
+        Vec4 Placement; //xyz center, w half the size
+        Vec4 Color;
+
+        using Layout = VertexBufferLayout<Instance, Vec4, Vec4>;
+    };
+
+    const unsigned int objectCount = 200000;
+    const float cube[] = {
+        -1, -1, -1,  1, -1, -1,  1, 1, -1,  -1, 1, -1,
+        -1, -1, 1,   1, -1, 1,   1, 1, 1,   -1, 1, 1
+    };
+    const unsigned int cubeIndices[] = {
+        0, 2, 1, 2, 0, 3,  4, 5, 6, 6, 7, 4,  0, 1, 5, 5, 4, 0,
+        3, 6, 2, 6, 3, 7,  0, 4, 7, 7, 3, 0,  1, 2, 6, 6, 5, 1
+    };
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> size(0.2f, 2.0f);
+    std::uniform_real_distribution<float> shade(0.2f, 1.0f);
+
+    std::vector<Instance> instances(objectCount);
+    FrustumCuller culler;
+    for (Instance& instance : instances) {
+        Vec3 center = { position(random), position(random) * 0.1f, position(random) };
+        float extent = size(random);
+
+        instance = { { center.x, center.y, center.z, extent }, { shade(random), shade(random), shade(random), 1.0f } };
+        culler.Add(center - Vec3{ extent, extent, extent }, center + Vec3{ extent, extent, extent });
+    }
+
+    Renderer renderer;
+    Shader shader("res/shaders/InstancedTransform.shader");
+    IndexBuffer ib(cubeIndices, 36);
+    VertexBuffer cubeBuffer(cube, sizeof(cube));
+    VertexBuffer instanceBuffer(nullptr, objectCount * sizeof(Instance), BufferStrategy::Orphan);
+
+    VertexArray va;
+    va.AddBuffer<VertexBufferLayout<Vec3, Vec3>>(cubeBuffer);
+    va.AddBuffer<Instance::Layout>(instanceBuffer, 1);
+    va.SetIndexBuffer(ib);
+
+    ThreadPool pool;
+    std::vector<unsigned int> visible;
+    std::vector<Instance> visibleInstances;
+    visibleInstances.reserve(objectCount);
+
+    Mat4 projection = Perspective(1.0f, 640.0f / 480.0f, 0.5f, 150.0f);
+    auto viewProjection = [&](long frame) {
+        float angle = frame * 0.01f;
+        return Multiply(projection, LookAt({ 0.0f, 5.0f, 0.0f }, { std::cos(angle), 5.0f, std::sin(angle) }, { 0.0f, 1.0f, 0.0f }));
+    };
+
+    //the culling pass alone, on one thread and on the pool
+    FrameStats single, pooled;
+    for (long frame = 0; frame < frames; frame++) {
+        Frustum frustum = Frustum::FromMatrix(viewProjection(frame));
+
+        auto start = std::chrono::steady_clock::now();
+        culler.Cull(frustum, visible);
+        single.Add(MillisecondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        culler.Cull(frustum, visible, &pool);
+        pooled.Add(MillisecondsSince(start));
+    }
+
+    FrameStats all, culled;
+    size_t drawn = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (long frame = 0; frame < frames; frame++) {
+            auto frameStart = std::chrono::steady_clock::now();
+            Mat4 matrix = viewProjection(frame);
+
+            if (pass == 0) {
+                instanceBuffer.Update(0, instances.data(), objectCount * sizeof(Instance));
+                drawn = objectCount;
+            }
+            else {
+                culler.Cull(Frustum::FromMatrix(matrix), visible, &pool);
+
+                visibleInstances.clear();
+                for (unsigned int id : visible) {
+                    visibleInstances.push_back(instances[id]);
+                }
+                instanceBuffer.Update(0, visibleInstances.data(), (unsigned int)(visibleInstances.size() * sizeof(Instance)));
+                drawn += visible.size();
+            }
+
+            shader.Bind();
+            shader.SetUniformMat4f("u_ViewProjection", matrix.m);
+            renderer.Clear();
+            renderer.DrawInstanced(va, ib, shader, pass == 0 ? objectCount : (unsigned int)visible.size());
+            GLCall(glFinish());
+            context.SwapBuffers();
+
+            (pass == 0 ? all : culled).Add(MillisecondsSince(frameStart));
+        }
+    }
+
+    std::cout << objectCount << " objects, " << drawn / std::max(1L, frames) << " visible per frame on average, "
+        << pool.GetThreadCount() << " threads" << std::endl;
+    single.Print("  cull, one thread");
+    pooled.Print("  cull, thread pool");
+    all.Print("  draw everything");
+    culled.Print("  cull + draw visible");
+    return 0;
+}
+
+/*
+* Creates every shader in res/shaders three times: without the program cache, with an empty one (cold,
+* it compiles and stores) and with the binaries the cold run left (warm). Drivers often have a shader
+* cache of their own that speeds up the first two as well. Mesa only offers program binaries while
+* its cache is on, so MESA_SHADER_CACHE_DISABLE=true turns ours off too.
+*/
+static int BenchmarkShaderCache(HeadlessContext& context, long frames)
+{
+    std::vector<std::string> paths;
+    for (const auto& entry : std::filesystem::directory_iterator("res/shaders")) {
+        if (entry.path().extension() == ".shader") {
+            paths.push_back(entry.path().generic_string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::string directory = ProgramCache::GetDirectory();
+    std::string benchDirectory = (directory.empty() ? std::string("shadercache") : directory) + "/bench";
+
+    //every run creates all the shaders, deletes them and says how long the creating took.
+    auto run = [&](const char* label, const std::string& cacheDirectory, bool clear) {
+        FrameStats stats;
+        for (long frame = 0; frame < std::max(1L, std::min(frames, 20L)); frame++) {
+            if (clear) {
+                std::error_code error;
+                std::filesystem::remove_all(benchDirectory, error);
+            }
+            ProgramCache::SetDirectory(cacheDirectory);
+
+            auto start = std::chrono::steady_clock::now();
+            {
+                std::vector<std::unique_ptr<Shader>> shaders;
+                for (const std::string& path : paths) {
+                    shaders.emplace_back(new Shader(path));
+                }
+                GLCall(glFinish());
+                stats.Add(MillisecondsSince(start));
+            }
+            context.SwapBuffers();
+        }
+        stats.Print(label);
+    };
+
+    std::cout << paths.size() << " shaders" << std::endl;
+    ProgramCache::ResetStats();
+    run("  no cache", "", false);
+    run("  cold cache", benchDirectory, true);
+    run("  warm cache", benchDirectory, false);
+
+    ProgramCache::Stats stats = ProgramCache::GetStats();
+    std::cout << "  " << stats.hits << " loaded from binaries, " << stats.misses << " misses, " << stats.stored
+        << " stored, " << stats.rejected << " rejected" << std::endl;
+
+    ProgramCache::SetDirectory(directory);
+    return 0;
+}
+
+/*
+* The parser before the files were mapped: getline and a stringstream per stage, only vertex and fragment,
+* no #include. Kept to compare against.
+*/
+static void LegacyParseShader(const std::string& filepath, std::string& vertex, std::string& fragment)
+{
+    std::ifstream stream(filepath);
+    std::string line;
+    std::stringstream ss[2];
+    int type = -1;
+
+    while (std::getline(stream, line)) {
+        if (line.find("#shader") != std::string::npos) {
+            if (line.find("vertex") != std::string::npos) {
+                type = 0;
+            }
+            else if (line.find("fragment") != std::string::npos) {
+                type = 1;
+            }
+        }
+        else if (type >= 0) {
+            ss[type] << line << '\n';
+        }
+    }
+    vertex = ss[0].str();
+    fragment = ss[1].str();
+}
+
+/*
+* Writes a shader library to a temporary directory and parses it over and over: big standalone files
+* with the old parser and with ParseShader, and small files that include a few big shared ones, where
+* the mapped files of the shared ones are reused. Nothing is compiled, this only measures the parsing.
+*/
+static int BenchmarkShaderParse(HeadlessContext& context, long frames)
+{
+    const int standaloneCount = 64, includingCount = 256, commonCount = 16, linesPerSection = 2000;
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "tcn_shaderparse";
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::create_directories(directory / "common");
+
+    auto writeLines = [](std::ofstream& file, const char* prefix, int lines) {
+        for (int i = 0; i < lines; i++) {
+            file << "    float " << prefix << i << " = sin(float(" << i << ") * 0.5) + cos(u_Time * " << i << ".0);\n";
+        }
+    };
+
+    std::vector<std::string> standalone, including;
+    for (int s = 0; s < standaloneCount; s++) {
+        std::string path = (directory / ("standalone" + std::to_string(s) + ".shader")).generic_string();
+        std::ofstream file(path);
+        file << "#shader vertex\n#version 330 core\nuniform float u_Time;\nvoid main()\n{\n";
+        writeLines(file, "v", linesPerSection);
+        file << "    gl_Position = vec4(0.0);\n}\n#shader fragment\n#version 330 core\nuniform float u_Time;\nout vec4 color;\nvoid main()\n{\n";
+        writeLines(file, "f", linesPerSection);
+        file << "    color = vec4(1.0);\n}\n";
+        standalone.push_back(path);
+    }
+    for (int c = 0; c < commonCount; c++) {
+        std::ofstream file(directory / "common" / ("common" + std::to_string(c) + ".glsl"));
+        file << "float Common" << c << "()\n{\n";
+        writeLines(file, "c", linesPerSection / 4);
+        file << "    return 0.0;\n}\n";
+    }
+    for (int s = 0; s < includingCount; s++) {
+        std::string path = (directory / ("including" + std::to_string(s) + ".shader")).generic_string();
+        std::ofstream file(path);
+        file << "#shader vertex\n#version 330 core\nuniform float u_Time;\n";
+        for (int c = 0; c < 4; c++) {
+            file << "#include \"common/common" << (s + c) % commonCount << ".glsl\"\n";
+        }
+        file << "void main() { gl_Position = vec4(0.0); }\n#shader fragment\n#version 330 core\nuniform float u_Time;\n";
+        for (int c = 0; c < 4; c++) {
+            file << "#include \"common/common" << (s + c + 4) % commonCount << ".glsl\"\n";
+        }
+        file << "out vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+        including.push_back(path);
+    }
+
+    //every run parses the list once per frame and checks nothing was lost on the way.
+    auto run = [&](const char* label, const std::vector<std::string>& paths, bool legacy) {
+        FrameStats stats;
+        size_t bytes = 0;
+        for (long frame = 0; frame < std::max(1L, std::min(frames, 50L)); frame++) {
+            bytes = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (const std::string& path : paths) {
+                if (legacy) {
+                    std::string vertex, fragment;
+                    LegacyParseShader(path, vertex, fragment);
+                    bytes += vertex.size() + fragment.size();
+                }
+                else {
+                    ShaderProgramSource source = Shader::ParseShader(path);
+                    for (const std::vector<std::string_view>& stage : source.Stages) {
+                        for (std::string_view piece : stage) {
+                            bytes += piece.size();
+                        }
+                    }
+                }
+            }
+            stats.Add(MillisecondsSince(start));
+            context.SwapBuffers();
+        }
+        stats.Print(label);
+        std::cout << "    " << bytes / 1024 << " KB of source per frame" << std::endl;
+    };
+
+    std::cout << standaloneCount << " standalone shaders, " << includingCount << " shaders including 8 of " << commonCount << " shared files" << std::endl;
+    run("  getline (standalone)", standalone, true);
+    run("  mapped (standalone)", standalone, false);
+    run("  mapped (including)", including, false);
+
+    std::filesystem::remove_all(directory, error);
+    return 0;
+}
+
+/*
+* Builds every shader in res/shaders a few times over, with the program cache off, once one by one
+* with the Shader constructor and once through a ShaderQueue polled once per frame. "issue" is how
+* long the main thread spends adding them all, "ready" how long until the last one is finished.
+*/
+static int BenchmarkShaderQueue(HeadlessContext& context, long frames)
+{
+    std::vector<std::string> paths;
+    for (const auto& entry : std::filesystem::directory_iterator("res/shaders")) {
+        if (entry.path().extension() == ".shader") {
+            paths.push_back(entry.path().generic_string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    const int copies = 4;
+    std::string directory = ProgramCache::GetDirectory();
+    ProgramCache::SetDirectory("");
+
+    FrameStats sync, issue, ready, pollFrames;
+    bool parallel = false;
+    for (long run = 0; run < std::max(1L, std::min(frames, 20L)); run++) {
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::unique_ptr<Shader>> shaders;
+            for (int copy = 0; copy < copies; copy++) {
+                for (const std::string& path : paths) {
+                    shaders.emplace_back(new Shader(path));
+                }
+            }
+            sync.Add(MillisecondsSince(start));
+        }
+        context.SwapBuffers();
+
+        {
+            auto start = std::chrono::steady_clock::now();
+            ShaderQueue queue;
+            parallel = queue.IsParallel();
+            std::vector<ShaderQueue::Handle> handles;
+            for (int copy = 0; copy < copies; copy++) {
+                for (const std::string& path : paths) {
+                    handles.push_back(queue.Add(path));
+                }
+            }
+            issue.Add(MillisecondsSince(start));
+
+            //a frame is a clear and a swap, the rest of the time the driver keeps compiling.
+            long polls = 0;
+            while (queue.GetPendingCount() > 0) {
+                queue.Poll();
+                GLCall(glClear(GL_COLOR_BUFFER_BIT));
+                context.SwapBuffers();
+                polls++;
+            }
+            ready.Add(MillisecondsSince(start));
+            pollFrames.Add((double)polls);
+
+            for (const ShaderQueue::Handle& handle : handles) {
+                ASSERT(handle.IsReady());
+            }
+        }
+    }
+
+    std::cout << paths.size() * copies << " programs, " << (parallel ? "GL_KHR_parallel_shader_compile" : "no parallel compile extension") << std::endl;
+    sync.Print("  Shader constructor");
+    issue.Print("  queue issue");
+    ready.Print("  queue ready");
+    std::cout << "  " << pollFrames.Average() << " frames polled on average" << std::endl;
+
+    ProgramCache::SetDirectory(directory);
+    return 0;
+}
+
+/*
+* Watches a shader in a temporary directory and rewrites a file it includes every few frames, every
+* fourth time with an error. Says how long Update takes on the frames, which should never be spent
+* on files, and how long it takes from saving a file until the new program is in the Shader.
+*/
+static int BenchmarkHotReload(HeadlessContext& context, long frames)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "tcn_hotreload";
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::create_directories(directory);
+
+    std::string path = (directory / "Reload.shader").generic_string();
+    {
+        std::ofstream file(path);
+        file << "#shader vertex\n#version 330 core\nlayout(location = 0) in vec4 position;\nvoid main() { gl_Position = position; }\n"
+            "#shader fragment\n#version 330 core\n#include \"Color.glsl\"\nout vec4 color;\nvoid main() { color = Color(); }\n";
+    }
+
+    //editors replace the file, writing in place would pull it from under the mapping.
+    auto writeColor = [&](int version, bool broken) {
+        std::string temporary = (directory / "Color.glsl.tmp").generic_string();
+        {
+            std::ofstream file(temporary);
+            file << "uniform float u_Scale;\nvec4 Color() { return vec4(" << (version % 10) / 10.0 << ", 0.5, u_Scale, 1.0)" << (broken ? "" : ";") << " }\n";
+        }
+        std::filesystem::rename(temporary, directory / "Color.glsl");
+    };
+    writeColor(0, false);
+
+    unsigned long reloadsBefore = 0;
+    {
+        Shader shader(path);
+        ShaderWatcher watcher;
+        watcher.Watch(shader);
+
+        //the thread has to parse it once before it knows what to watch.
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        FrameStats update, latency;
+        const long period = 30;
+        long total = std::max(frames, 4 * period);
+        int version = 0;
+        auto saved = std::chrono::steady_clock::now();
+        unsigned int program = shader.GetRendererID();
+        unsigned int failures = 0;
+
+        for (long frame = 0; frame < total; frame++) {
+            if (frame % period == 0) {
+                version++;
+                writeColor(version, version % 4 == 0);
+                saved = std::chrono::steady_clock::now();
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            watcher.Update();
+            update.Add(MillisecondsSince(start));
+
+            if (shader.GetRendererID() != program) {
+                program = shader.GetRendererID();
+                latency.Add(MillisecondsSince(saved));
+            }
+            if (watcher.GetFailureCount() != failures) {
+                failures = watcher.GetFailureCount();
+                ASSERT(shader.GetRendererID() == program); //a broken file keeps the old program
+            }
+
+            shader.Bind();
+            shader.SetUniform1f("u_Scale", 1.0f);
+            GLCall(glClear(GL_COLOR_BUFFER_BIT));
+            context.SwapBuffers();
+
+            //a frame at 60 Hz, so the thread gets to see the files between them.
+            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        }
+
+        update.Print("  Update");
+        latency.Print("  save to swap");
+        std::cout << "  " << watcher.GetReloadCount() << " reloads, " << watcher.GetFailureCount() << " kept the old program" << std::endl;
+        reloadsBefore = watcher.GetReloadCount();
+        watcher.Unwatch(shader);
+    }
+
+    std::filesystem::remove_all(directory, error);
+    return reloadsBefore > 0 ? 0 : -1;
+}
+
+/*
+* Every variant of Surface.shader: how long the first Get of each one takes (it compiles, the program
+* cache is off), then lots of Gets per frame picking variants by mask, against looking them up by a
+* string of keyword names the way a material system without masks would.
+*/
+static int BenchmarkVariants(HeadlessContext& context, long frames)
+{
+    std::string directory = ProgramCache::GetDirectory();
+    ProgramCache::SetDirectory("");
+
+    {
+        ShaderVariants surface("res/shaders/Surface.shader");
+        const std::vector<std::string>& keywords = surface.GetKeywords();
+        unsigned long long variantCount = 1ull << keywords.size();
+
+        //every input of the richest variant, the others leave some unread.
+        struct SurfaceVertex
+        {
+            Vec2 Position;
+            Vec4 Color;
+            Vec2 TexCoord;
+        };
+        SurfaceVertex vertices[] = {
+            { { -0.5f, -0.5f }, { 1.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f } },
+            { { 0.5f, -0.5f }, { 0.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f } },
+            { { 0.5f, 0.5f }, { 0.0f, 0.0f, 1.0f, 1.0f }, { 1.0f, 1.0f } },
+            { { -0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, 1.0f } },
+        };
+        Vec2 offset = { 0.0f, 0.0f };
+        unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+        VertexBuffer vb(vertices, sizeof(vertices));
+        VertexBuffer instances(&offset, sizeof(offset));
+        VertexArray va;
+        va.AddBuffer<VertexBufferLayout<SurfaceVertex, Vec2, Vec4, Vec2>>(vb);
+        va.AddBuffer<VertexBufferLayout<Vec2, Vec2>>(instances, 1);
+        IndexBuffer ib(indices, 6);
+        va.SetIndexBuffer(ib);
+        Renderer renderer;
+
+        FrameStats first;
+        for (unsigned long long mask = 0; mask < variantCount; mask++) {
+            auto start = std::chrono::steady_clock::now();
+            Shader& shader = surface.Get(mask);
+            first.Add(MillisecondsSince(start));
+
+            shader.Bind();
+            shader.SetUniform4f("u_Color", 1.0f, 1.0f, 1.0f, 1.0f);
+        }
+
+        //every variant draws once, to see they all link and run.
+        for (unsigned long long mask = 0; mask < variantCount; mask++) {
+            renderer.Draw(va, ib, surface.Get(mask));
+        }
+        context.SwapBuffers();
+
+        //the same shaders found by name, what the mask saves.
+        auto nameOf = [&](unsigned long long mask) {
+            std::string name;
+            for (size_t i = 0; i < keywords.size(); i++) {
+                if (mask & (1ull << i)) {
+                    name += keywords[i] + " ";
+                }
+            }
+            return name;
+        };
+        std::unordered_map<std::string, Shader*> byName;
+        for (unsigned long long mask = 0; mask < variantCount; mask++) {
+            byName[nameOf(mask)] = &surface.Get(mask);
+        }
+
+        //a frame of lookups is what a draw loop with lookupsPerFrame draws would spend finding its shaders.
+        const int lookupsPerFrame = 100000;
+        FrameStats maskFrames, nameFrames;
+        unsigned long long sink = 0;
+        for (long frame = 0; frame < frames; frame++) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < lookupsPerFrame; i++) {
+                sink += surface.Get((unsigned long long)(i + frame) % variantCount).GetRendererID();
+            }
+            maskFrames.Add(MillisecondsSince(start));
+
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < lookupsPerFrame; i++) {
+                sink += byName[nameOf((unsigned long long)(i + frame) % variantCount)]->GetRendererID();
+            }
+            nameFrames.Add(MillisecondsSince(start));
+        }
+
+        std::cout << keywords.size() << " keywords, " << surface.GetVariantCount() << " variants" << std::endl;
+        first.Print("  first Get (compiles)");
+        maskFrames.Print("  100k lookups by mask");
+        nameFrames.Print("  100k lookups by name");
+        ASSERT(sink != 0); //so the lookups aren't optimized away
+    }
+
+    ProgramCache::SetDirectory(directory);
+    return 0;
+}
+
+/*
+* Prints the reflection tables of every shader in res/shaders and how long reflecting each one takes,
+* then checks that validation catches a vertex array feeding integers to a float input.
+*/
+static int BenchmarkReflection(HeadlessContext& context, long frames)
+{
+    std::vector<std::string> paths;
+    for (const auto& entry : std::filesystem::directory_iterator("res/shaders")) {
+        if (entry.path().extension() == ".shader") {
+            paths.push_back(entry.path().generic_string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    FrameStats stats;
+    for (const std::string& path : paths) {
+        Shader shader(path);
+        std::cout << path << std::endl;
+        shader.GetReflection().Print(std::cout);
+
+        ShaderReflection reflection;
+        for (long frame = 0; frame < std::max(1L, std::min(frames, 100L)); frame++) {
+            auto start = std::chrono::steady_clock::now();
+            reflection.Reflect(shader.GetRendererID());
+            stats.Add(MillisecondsSince(start));
+        }
+    }
+    stats.Print("Reflect");
+
+    //Basic.shader reads a vec4 at location 0, an int there is a mistake.
+    Shader basic("res/shaders/Basic.shader");
+    int integers[] = { 0, 1, 2, 3 };
+    VertexBuffer vb(integers, sizeof(integers));
+    VertexArray good, bad;
+    good.AddBuffer<VertexBufferLayout<Vec4, Vec4>>(vb);
+    bad.AddBuffer<VertexBufferLayout<int, int>>(vb);
+    std::cout << "Validating a vertex array of ints against Basic.shader:" << std::endl;
+    bool caught = basic.Validate(good) && !basic.Validate(bad);
+    std::cout << (caught ? "caught" : "missed") << std::endl;
+
+    context.SwapBuffers();
+    return caught ? 0 : -1;
+}
+
+/*
+* Thousands of small meshes drawn three ways: each with buffers and a vertex array of its own, all in two
+* BufferPools with one vertex array and a glDrawElementsBaseVertex each, and the pooled ones with a single
+* DrawIndirect. Then it frees half of them at random, refills the holes with meshes of other sizes, and
+* compacts the pools, printing what the allocator thinks of the free space before and after. Every mesh
+* is read back after compacting to check the data moved with it.
+*/
+static int BenchmarkSubAllocation(HeadlessContext& context, long frames)
+{
+    struct Mesh
+    {
+        std::vector<Vec2> Vertices;
+        std::vector<unsigned int> Indices;
+        std::unique_ptr<VertexBuffer> Vertex;
+        std::unique_ptr<IndexBuffer> Index;
+    };
+
+    const unsigned int meshCount = 4000;
+    std::mt19937 random(25);
+    std::uniform_int_distribution<unsigned int> sides(3, 64);
+    std::uniform_real_distribution<float> position(-0.95f, 0.95f);
+
+    //a small polygon drawn as a fan
+    auto makeMesh = [&](Mesh& mesh) {
+        unsigned int count = sides(random);
+        Vec2 center = { position(random), position(random) };
+        mesh.Vertices.resize(count);
+        mesh.Indices.clear();
+        for (unsigned int i = 0; i < count; i++) {
+            float angle = 6.2831853f * i / count;
+            mesh.Vertices[i] = { center.x + 0.02f * std::cos(angle), center.y + 0.02f * std::sin(angle) };
+        }
+        for (unsigned int i = 1; i + 1 < count; i++) {
+            mesh.Indices.insert(mesh.Indices.end(), { 0, i, i + 1 });
+        }
+    };
+
+    //the pools go first so they outlive the buffers of the meshes. 16 bit indices because they are relative to the base vertex.
+    BufferPool vertexPool(GL_ARRAY_BUFFER, sizeof(Vec2), 1 << 20);
+    BufferPool indexPool(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short), 1 << 21);
+
+    std::vector<Mesh> meshes(meshCount);
+    for (Mesh& mesh : meshes) {
+        makeMesh(mesh);
+    }
+
+    Renderer renderer;
+    Shader shader("res/shaders/Basic.shader");
+    shader.Bind();
+    shader.SetUniform4f("u_Color", 0.8f, 0.4f, 0.2f, 1.0f);
+
+    using Layout = VertexBufferLayout<Vec2, Vec2>;
+
+    //one of everything per mesh
+    std::vector<std::unique_ptr<VertexBuffer>> ownVertices;
+    std::vector<std::unique_ptr<IndexBuffer>> ownIndices;
+    std::vector<std::unique_ptr<VertexArray>> ownArrays;
+    for (Mesh& mesh : meshes) {
+        ownVertices.emplace_back(new VertexBuffer(mesh.Vertices.data(), (unsigned int)(mesh.Vertices.size() * sizeof(Vec2))));
+        ownIndices.emplace_back(new IndexBuffer(mesh.Indices.data(), (unsigned int)mesh.Indices.size()));
+        ownArrays.emplace_back(new VertexArray());
+        ownArrays.back()->AddBuffer<Layout>(*ownVertices.back());
+        ownArrays.back()->SetIndexBuffer(*ownIndices.back());
+    }
+
+    //everything in two pools, one vertex array.
+    for (Mesh& mesh : meshes) {
+        mesh.Vertex.reset(new VertexBuffer(vertexPool, mesh.Vertices.data(), (unsigned int)(mesh.Vertices.size() * sizeof(Vec2))));
+        mesh.Index.reset(new IndexBuffer(indexPool, mesh.Indices.data(), (unsigned int)mesh.Indices.size()));
+        if (!mesh.Vertex->IsValid() || !mesh.Index->IsValid()) {
+            return -1;
+        }
+    }
+    VertexArray va;
+    va.AddBuffer<Layout>(vertexPool);
+    va.SetIndexBuffer(indexPool);
+
+    IndirectCommandBuffer commands(meshCount);
+    auto recordCommands = [&]() {
+        commands.Clear();
+        for (const Mesh& mesh : meshes) {
+            commands.Add(mesh.Index->GetCount(), mesh.Index->GetFirstIndex(), (int)mesh.Vertex->GetBaseVertex());
+        }
+    };
+    recordCommands();
+
+    FrameStats own, pooled, indirect;
+    for (long frame = 0; frame < frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        renderer.Clear();
+        for (unsigned int i = 0; i < meshCount; i++) {
+            renderer.Draw(*ownArrays[i], *ownIndices[i], shader);
+        }
+        GLCall(glFinish());
+        own.Add(MillisecondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        renderer.Clear();
+        for (const Mesh& mesh : meshes) {
+            renderer.Draw(va, *mesh.Vertex, *mesh.Index, shader);
+        }
+        GLCall(glFinish());
+        pooled.Add(MillisecondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        renderer.Clear();
+        renderer.DrawIndirect(va, *meshes[0].Index, shader, commands);
+        GLCall(glFinish());
+        indirect.Add(MillisecondsSince(start));
+
+        context.SwapBuffers();
+    }
+
+    std::cout << meshCount << " meshes" << std::endl;
+    own.Print("  buffers and vertex array per mesh");
+    pooled.Print("  pooled, base vertex draws");
+    indirect.Print("  pooled, one DrawIndirect");
+
+    auto printStats = [](const char* label, const BufferPool& pool) {
+        BufferPool::Stats stats = pool.GetStats();
+        std::cout << "    " << label << ": " << stats.Allocations << " allocations, " << stats.Used << " bytes used, "
+            << stats.Free << " free in " << stats.FreeRegions << " regions, largest " << stats.LargestFree
+            << ", fragmentation " << stats.Fragmentation << std::endl;
+    };
+
+    //churn: half of the meshes go away and others of different sizes take their place.
+    for (int round = 0; round < 4; round++) {
+        for (Mesh& mesh : meshes) {
+            if (random() & 1) {
+                mesh.Vertex.reset();
+                mesh.Index.reset();
+            }
+        }
+        for (Mesh& mesh : meshes) {
+            if (!mesh.Vertex) {
+                makeMesh(mesh);
+                mesh.Vertex.reset(new VertexBuffer(vertexPool, mesh.Vertices.data(), (unsigned int)(mesh.Vertices.size() * sizeof(Vec2))));
+                mesh.Index.reset(new IndexBuffer(indexPool, mesh.Indices.data(), (unsigned int)mesh.Indices.size()));
+            }
+        }
+    }
+    //and a last half freed, so there are holes to close.
+    for (Mesh& mesh : meshes) {
+        if (random() & 1) {
+            mesh.Vertex.reset();
+            mesh.Index.reset();
+        }
+    }
+    meshes.erase(std::remove_if(meshes.begin(), meshes.end(), [](const Mesh& mesh) { return !mesh.Vertex; }), meshes.end());
+
+    std::cout << "  after churn, " << meshes.size() << " meshes left" << std::endl;
+    printStats("vertices", vertexPool);
+    printStats("indices", indexPool);
+
+    auto start = std::chrono::steady_clock::now();
+    unsigned int moved = vertexPool.Compact() + indexPool.Compact();
+    GLCall(glFinish());
+    double compactTime = MillisecondsSince(start);
+
+    std::cout << "  compacted " << moved << " bytes in " << compactTime << " ms" << std::endl;
+    printStats("vertices", vertexPool);
+    printStats("indices", indexPool);
+
+    //the data must have followed the allocations.
+    unsigned int broken = 0;
+    std::vector<Vec2> vertices;
+    std::vector<unsigned short> indices;
+    for (const Mesh& mesh : meshes) {
+        vertices.resize(mesh.Vertices.size());
+        GLState::BindBuffer(GL_COPY_READ_BUFFER, vertexPool.GetRendererID());
+        GLCall(glGetBufferSubData(GL_COPY_READ_BUFFER, mesh.Vertex->GetOffset(), vertices.size() * sizeof(Vec2), vertices.data()));
+        indices.resize(mesh.Indices.size());
+        GLState::BindBuffer(GL_COPY_READ_BUFFER, indexPool.GetRendererID());
+        GLCall(glGetBufferSubData(GL_COPY_READ_BUFFER, mesh.Index->GetOffset(), indices.size() * sizeof(unsigned short), indices.data()));
+
+        bool same = memcmp(vertices.data(), mesh.Vertices.data(), vertices.size() * sizeof(Vec2)) == 0;
+        for (size_t i = 0; i < indices.size(); i++) {
+            same = same && indices[i] == mesh.Indices[i];
+        }
+        broken += same ? 0 : 1;
+    }
+    std::cout << "  " << (broken ? "data lost in " + std::to_string(broken) + " meshes" : std::string("every mesh intact")) << std::endl;
+
+    //the offsets changed, the commands are recorded again. The vertex array didn't change.
+    recordCommands();
+    renderer.Clear();
+    renderer.DrawIndirect(va, *meshes[0].Index, shader, commands);
+    context.SwapBuffers();
+
+    //the allocator alone, without GL
+    OffsetAllocator allocator(1 << 24);
+    std::vector<unsigned int> live;
+    std::uniform_int_distribution<unsigned int> allocationSize(1, 4096);
+    const int operations = 1000000;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < operations; i++) {
+        if (!live.empty() && (live.size() > 2000 || (random() & 1))) {
+            size_t index = random() % live.size();
+            allocator.Free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+        }
+        else {
+            unsigned int allocation = allocator.Allocate(allocationSize(random));
+            if (allocation != OffsetAllocator::NoSpace) {
+                live.push_back(allocation);
+            }
+        }
+    }
+    double allocatorTime = MillisecondsSince(start);
+    std::cout << "  OffsetAllocator: " << operations << " random allocations and frees in " << allocatorTime << " ms ("
+        << allocatorTime * 1000000.0 / operations << " ns each)" << std::endl;
+
+    return broken ? -1 : 0;
+}
+
+int RunBenchmark(const char* name, HeadlessContext& context, long frames)
+{
+    if (strcmp(name, "glcall") == 0) {
+        return BenchmarkGLCall(context, frames);
+    }
+    if (strcmp(name, "uniforms") == 0) {
+        return BenchmarkUniforms(context, frames);
+    }
+    if (strcmp(name, "uploads") == 0) {
+        return BenchmarkUploads(context, frames);
+    }
+    if (strcmp(name, "batch") == 0) {
+        return BenchmarkBatch(context, frames);
+    }
+    if (strcmp(name, "instancing") == 0) {
+        return BenchmarkInstancing(context, frames);
+    }
+    if (strcmp(name, "meshopt") == 0) {
+        return BenchmarkMeshOptimizer(context, frames);
+    }
+    if (strcmp(name, "packing") == 0) {
+        return BenchmarkPacking(context, frames);
+    }
+    if (strcmp(name, "meshlets") == 0) {
+        return BenchmarkMeshlets(context, frames);
+    }
+    if (strcmp(name, "culling") == 0) {
+        return BenchmarkCulling(context, frames);
+    }
+    if (strcmp(name, "shadercache") == 0) {
+        return BenchmarkShaderCache(context, frames);
+    }
+    if (strcmp(name, "shaderparse") == 0) {
+        return BenchmarkShaderParse(context, frames);
+    }
+    if (strcmp(name, "shaderqueue") == 0) {
+        return BenchmarkShaderQueue(context, frames);
+    }
+    if (strcmp(name, "hotreload") == 0) {
+        return BenchmarkHotReload(context, frames);
+    }
+    if (strcmp(name, "variants") == 0) {
+        return BenchmarkVariants(context, frames);
+    }
+    if (strcmp(name, "reflection") == 0) {
+        return BenchmarkReflection(context, frames);
+    }
+    if (strcmp(name, "suballoc") == 0) {
+        return BenchmarkSubAllocation(context, frames);
+    }
+
+    std::cout << "Unknown benchmark '" << name << "'. Available: glcall, uniforms, uploads, batch, instancing, meshopt, packing, meshlets, culling, shadercache, shaderparse, shaderqueue, hotreload, variants, reflection, suballoc" << std::endl;
+    return -1;
+}
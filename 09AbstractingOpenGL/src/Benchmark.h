@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+class HeadlessContext;
+
+/*
+* Collects frame times (in milliseconds) and summarises them.
+*/
+class FrameStats
+{
+private:
+	std::vector<double> m_Samples;
+public:
+	void Add(double milliseconds) { m_Samples.push_back(milliseconds); }
+	void Clear() { m_Samples.clear(); }
+
+	double Average() const;
+	double Percentile(double p) const; //p in [0, 100]
+	inline size_t GetCount() const { return m_Samples.size(); }
+
+	//prints "label: avg X ms, p50 Y ms, p99 Z ms (N frames)"
+	void Print(const char* label) const;
+};
+
+//milliseconds elapsed since start
+inline double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+* Runs the benchmark called name (--bench name) on the headless context for the given number of frames.
+* It returns the exit code for main.
+*/
+int RunBenchmark(const char* name, HeadlessContext& context, long frames);
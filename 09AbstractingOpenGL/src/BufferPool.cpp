@@ -0,0 +1,122 @@
+#include "BufferPool.h"
+#include "Renderer.h"
+#include "GLState.h"
+
+#include <vector>
+
+BufferPool::BufferPool(unsigned int target, unsigned int elementSize, unsigned int capacity)
+    : m_Target(target), m_ElementSize(elementSize), m_Allocator(capacity)
+{
+    ASSERT(elementSize > 0);
+
+    GLCall(glGenBuffers(1, &m_RendererID));
+
+    //GL_COPY_WRITE_BUFFER so an element buffer doesn't end up in whatever VAO is bound.
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+    GLCall(glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)capacity * elementSize, nullptr, GL_STATIC_DRAW));
+}
+
+BufferPool::~BufferPool()
+{
+    //every VertexBuffer or IndexBuffer made in the pool has to be gone before it.
+    ASSERT(m_Allocator.GetStats().Allocations == 0);
+    GLState::DeleteBuffer(m_RendererID);
+}
+
+unsigned int BufferPool::Allocate(const void* data, unsigned int size)
+{
+    ASSERT(size % m_ElementSize == 0);
+
+    unsigned int allocation = m_Allocator.Allocate(size / m_ElementSize);
+    if (allocation == OffsetAllocator::NoSpace) {
+        return allocation;
+    }
+
+    if (data) {
+        GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+        GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, GetOffset(allocation), size, data));
+    }
+    return allocation;
+}
+
+void BufferPool::Free(unsigned int allocation)
+{
+    m_Allocator.Free(allocation);
+}
+
+void BufferPool::Update(unsigned int allocation, unsigned int offset, const void* data, unsigned int size)
+{
+    ASSERT(offset + size <= GetSize(allocation));
+
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+    GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, GetOffset(allocation) + offset, size, data));
+}
+
+unsigned int BufferPool::Compact()
+{
+    struct Move
+    {
+        unsigned int from;
+        unsigned int to;
+        unsigned int size;
+    };
+
+    std::vector<Move> moves;
+    unsigned int moved = 0;
+    m_Allocator.Compact([&](unsigned int from, unsigned int to, unsigned int size) {
+        moves.push_back({ from * m_ElementSize, to * m_ElementSize, size * m_ElementSize });
+        moved += size * m_ElementSize;
+    });
+
+    if (moves.empty()) {
+        return 0;
+    }
+
+    /*
+    * glCopyBufferSubData can't copy between overlapping ranges of the same buffer, and a range that moves
+    * less than its size overlaps itself. So everything that moves goes to a scratch buffer, packed, and comes
+    * back to its new place. It all stays on the GPU, in order with the draws around it.
+    */
+    unsigned int scratch;
+    GLCall(glGenBuffers(1, &scratch));
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+    GLCall(glBufferData(GL_COPY_WRITE_BUFFER, moved, nullptr, GL_STREAM_COPY));
+
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, m_RendererID);
+    unsigned int packed = 0;
+    for (const Move& move : moves) {
+        GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, move.from, packed, move.size));
+        packed += move.size;
+    }
+
+    GLState::BindBuffer(GL_COPY_READ_BUFFER, scratch);
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+    packed = 0;
+    for (const Move& move : moves) {
+        GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, packed, move.to, move.size));
+        packed += move.size;
+    }
+
+    GLState::DeleteBuffer(scratch);
+    return moved;
+}
+
+BufferPool::Stats BufferPool::GetStats() const
+{
+    OffsetAllocator::Stats elements = m_Allocator.GetStats();
+
+    Stats stats;
+    stats.Capacity = m_Allocator.GetCapacity() * m_ElementSize;
+    stats.Used = elements.Used * m_ElementSize;
+    stats.Free = elements.Free * m_ElementSize;
+    stats.LargestFree = elements.LargestFree * m_ElementSize;
+    stats.FreeRegions = elements.FreeRegions;
+    stats.Allocations = elements.Allocations;
+    stats.Fragmentation = elements.Fragmentation;
+    return stats;
+}
+
+void BufferPool::Bind() const
+{
+    GLState::BindBuffer(m_Target, m_RendererID);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "OffsetAllocator.h"
+
+/*
+* One big GL buffer that many VertexBuffers or IndexBuffers live in, so a whole scene can be drawn
+* from one vertex array: each mesh is a range of the pool, and the draws say where it is with a base
+* vertex and a first index instead of binding other buffers.
+*
+*   BufferPool vertices(GL_ARRAY_BUFFER, sizeof(Vertex), 1 << 20);
+*   BufferPool indices(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short), 1 << 22);
+*   VertexBuffer vb(vertices, data, size);   //a range of the pool
+*   IndexBuffer ib(indices, data, count);
+*   va.AddBuffer<Vertex::Layout>(vertices);  //once for every mesh in the pool
+*   va.SetIndexBuffer(indices);
+*   renderer.Draw(va, vb, ib, shader);
+*
+* The ranges are counted in elements (vertices or indices), so every offset is a whole base vertex.
+* Compact slides the ranges together inside the same buffer object, so vertex arrays stay valid,
+* but the offsets change: base vertices and first indices must be read again after it.
+*/
+class BufferPool
+{
+public:
+	struct Stats
+	{
+		unsigned int Capacity;		//bytes
+		unsigned int Used;
+		unsigned int Free;
+		unsigned int LargestFree;
+		unsigned int FreeRegions;
+		unsigned int Allocations;
+		float Fragmentation;		//1 - LargestFree / Free
+	};
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Target;
+	unsigned int m_ElementSize;	//bytes
+	OffsetAllocator m_Allocator;
+public:
+	//capacity in elements of elementSize bytes.
+	BufferPool(unsigned int target, unsigned int elementSize, unsigned int capacity);
+	~BufferPool();
+
+	BufferPool(const BufferPool&) = delete;
+	BufferPool& operator=(const BufferPool&) = delete;
+
+	//size bytes, a multiple of the element size. data may be nullptr. Returns OffsetAllocator::NoSpace when it doesn't fit.
+	unsigned int Allocate(const void* data, unsigned int size);
+	void Free(unsigned int allocation);
+
+	//writes size bytes at offset inside the allocation.
+	void Update(unsigned int allocation, unsigned int offset, const void* data, unsigned int size);
+
+	inline unsigned int GetOffset(unsigned int allocation) const { return m_Allocator.GetOffset(allocation) * m_ElementSize; }
+	inline unsigned int GetFirstElement(unsigned int allocation) const { return m_Allocator.GetOffset(allocation); }
+	inline unsigned int GetSize(unsigned int allocation) const { return m_Allocator.GetSize(allocation) * m_ElementSize; }
+
+	//moves every allocation to the front of the buffer on the GPU. Returns the bytes it moved.
+	unsigned int Compact();
+
+	Stats GetStats() const;
+
+	void Bind() const;
+
+	inline unsigned int GetTarget() const { return m_Target; }
+	inline unsigned int GetElementSize() const { return m_ElementSize; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+};
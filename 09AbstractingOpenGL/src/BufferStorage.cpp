@@ -0,0 +1,226 @@
+#include "BufferStorage.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "BufferPool.h"
+
+#include <cstring>
+#include <iostream>
+
+const char* BufferStrategyName(BufferStrategy strategy)
+{
+    switch (strategy) {
+    case BufferStrategy::Static: return "static";
+    case BufferStrategy::SubData: return "glBufferSubData";
+    case BufferStrategy::Orphan: return "orphan";
+    case BufferStrategy::MapUnsynchronized: return "map-unsynchronized";
+    case BufferStrategy::Persistent: return "persistent";
+    }
+    return "unknown";
+}
+
+BufferStorage::BufferStorage(unsigned int target, const void* data, unsigned int size, BufferStrategy strategy, unsigned int frames)
+    : m_Target(target), m_Size(size), m_Strategy(strategy), m_Mapped(nullptr), m_FrameCount(1), m_Frame(0), m_Stalls(0),
+      m_Pool(nullptr), m_Allocation(0)
+{
+    for (void*& fence : m_Fences) {
+        fence = nullptr;
+    }
+
+    GLCall(glGenBuffers(
+        1,      //number of buffers
+        &m_RendererID //buffer id
+    ));
+
+    GLState::BindBuffer(
+        target,
+        m_RendererID //we select this buffer to work on it next.
+    );
+
+    if (strategy != BufferStrategy::Persistent) {
+        GLCall(glBufferData(
+            target,
+            size,  //size in bytes
+            data,          //the data
+            strategy == BufferStrategy::Static ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW //a hint about the use we are going to make of it
+        ));
+        return;
+    }
+
+    ASSERT(GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+    ASSERT(frames > 0 && frames <= MaxFrames);
+    m_FrameCount = frames;
+
+    //immutable storage that stays mapped for the life of the buffer. Coherent means our writes
+    //are visible to the GPU without flushing them.
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    GLCall(glBufferStorage(
+        target,
+        (GLsizeiptr)size * frames,  //one region per frame in flight
+        nullptr,
+        flags
+    ));
+
+    m_Mapped = GLCallValue((unsigned char*)glMapBufferRange(target, 0, (GLsizeiptr)size * frames, flags));
+    ASSERT(m_Mapped);
+
+    //the initial data goes to every region so any of them can be drawn before it is rewritten.
+    if (data) {
+        for (unsigned int i = 0; i < frames; i++) {
+            memcpy(m_Mapped + i * size, data, size);
+        }
+    }
+}
+
+BufferStorage::BufferStorage(BufferPool& pool, const void* data, unsigned int size)
+    : m_RendererID(pool.GetRendererID()), m_Target(pool.GetTarget()), m_Size(size), m_Strategy(BufferStrategy::SubData),
+      m_Mapped(nullptr), m_FrameCount(1), m_Frame(0), m_Stalls(0), m_Pool(&pool)
+{
+    for (void*& fence : m_Fences) {
+        fence = nullptr;
+    }
+
+    m_Allocation = pool.Allocate(data, size);
+    if (m_Allocation == OffsetAllocator::NoSpace) {
+        //the caller finds out with IsValid. There is nothing to write to, so nothing can be.
+        std::cout << "BufferPool " << pool.GetRendererID() << " has no room for " << size << " bytes" << std::endl;
+        m_Size = 0;
+    }
+}
+
+BufferStorage::~BufferStorage()
+{
+    if (m_Pool) {
+        //the buffer is the pool's, we only give our range back.
+        if (m_Allocation != OffsetAllocator::NoSpace) {
+            m_Pool->Free(m_Allocation);
+        }
+        return;
+    }
+
+    for (void* fence : m_Fences) {
+        if (fence) {
+            GLCall(glDeleteSync((GLsync)fence));
+        }
+    }
+
+    //deleting a buffer unmaps it.
+    GLState::DeleteBuffer(m_RendererID);
+}
+
+void BufferStorage::Bind() const
+{
+    GLState::BindBuffer(
+        m_Target,
+        m_RendererID //we select this buffer to work on it next.
+    );
+}
+
+void BufferStorage::UnBind() const
+{
+    GLState::BindBuffer(
+        m_Target,
+        0 //to unbind
+    );
+}
+
+void BufferStorage::Update(unsigned int offset, const void* data, unsigned int size)
+{
+    //a pooled buffer that didn't fit has nowhere to write.
+    if (!IsValid()) {
+        return;
+    }
+
+    ASSERT(offset + size <= m_Size);
+
+    if (m_Pool) {
+        m_Pool->Update(m_Allocation, offset, data, size);
+        return;
+    }
+
+    if (m_Strategy == BufferStrategy::Persistent) {
+        memcpy(m_Mapped + GetFrameOffset() + offset, data, size);
+        return;
+    }
+
+    //GL_COPY_WRITE_BUFFER so updating an index buffer doesn't attach it to whatever VAO is bound.
+    GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+
+    switch (m_Strategy) {
+    case BufferStrategy::Orphan: {
+        //the driver gives us new storage and frees the old one when the GPU is done with it, no waiting.
+        GLCall(glBufferData(GL_COPY_WRITE_BUFFER, m_Size, nullptr, GL_DYNAMIC_DRAW));
+        GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
+        break;
+    }
+
+    case BufferStrategy::MapUnsynchronized: {
+        void* mapped = GLCallValue(glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+        if (!mapped) {
+            //the driver wouldn't map it, the data still has to get there.
+            GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
+            break;
+        }
+        memcpy(mapped, data, size);
+        GLCall(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+        break;
+    }
+
+    default: {
+        GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
+        break;
+    }
+    }
+}
+
+bool BufferStorage::IsValid() const
+{
+    return !m_Pool || m_Allocation != OffsetAllocator::NoSpace;
+}
+
+unsigned int BufferStorage::GetOffset() const
+{
+    return m_Pool && IsValid() ? m_Pool->GetOffset(m_Allocation) : 0;
+}
+
+unsigned int BufferStorage::GetFirstElement() const
+{
+    return m_Pool && IsValid() ? m_Pool->GetFirstElement(m_Allocation) : 0;
+}
+
+void* BufferStorage::BeginFrame()
+{
+    if (m_Strategy != BufferStrategy::Persistent) {
+        return nullptr;
+    }
+
+    GLsync fence = (GLsync)m_Fences[m_Frame];
+    if (fence) {
+        //most of the time the GPU finished this region frames ago and this returns straight away.
+        GLenum status = GLCallValue(glClientWaitSync(fence, 0, 0));
+        if (status == GL_TIMEOUT_EXPIRED) {
+            m_Stalls++;
+            do {
+                status = GLCallValue(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000)); //1 second
+            } while (status == GL_TIMEOUT_EXPIRED);
+        }
+        ASSERT(status != GL_WAIT_FAILED);
+
+        GLCall(glDeleteSync(fence));
+        m_Fences[m_Frame] = nullptr;
+    }
+
+    return m_Mapped + GetFrameOffset();
+}
+
+void BufferStorage::EndFrame()
+{
+    if (m_Strategy != BufferStrategy::Persistent) {
+        return;
+    }
+
+    //signalled once the GPU has executed everything issued so far, including the draws that read this region.
+    GLCall(m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    m_Frame = (m_Frame + 1) % m_FrameCount;
+}
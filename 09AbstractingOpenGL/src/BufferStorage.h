@@ -0,0 +1,79 @@
+#pragma once
+
+class BufferPool;
+
+/*
+* How the contents of a buffer get updated after it is created.
+*/
+enum class BufferStrategy
+{
+	Static,				//glBufferData with GL_STATIC_DRAW once; Update falls back to glBufferSubData
+	SubData,			//GL_DYNAMIC_DRAW storage updated with glBufferSubData
+	Orphan,				//glBufferData(nullptr) hands us fresh storage, then glBufferSubData. The rest of the buffer is lost
+	MapUnsynchronized,	//glMapBufferRange with GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT. The caller makes sure the GPU isn't reading the range
+	Persistent			//a persistently mapped ring of frame regions guarded by fences, see BeginFrame
+};
+
+const char* BufferStrategyName(BufferStrategy strategy);
+
+/*
+* The GL buffer object behind VertexBuffer and IndexBuffer.
+* Persistent buffers are FrameCount regions of the given size, persistently mapped, and each
+* frame writes its own region while the GPU may still be reading the previous ones:
+*
+*   void* data = buffer.BeginFrame();  //only waits if the GPU is FrameCount frames behind
+*   ...write the data, or call Update...
+*   draw with buffer.GetFrameOffset()
+*   buffer.EndFrame();                 //after the draw calls that read the region
+*
+* For the other strategies BeginFrame returns nullptr and EndFrame does nothing.
+*
+* A storage can also be a range of a BufferPool instead of a buffer of its own. Then GetRendererID is
+* the pool's buffer, GetOffset says where the range starts, and Update writes with glBufferSubData.
+*/
+class BufferStorage
+{
+public:
+	static const unsigned int MaxFrames = 4;
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Target;
+	unsigned int m_Size;		//bytes of one frame region for persistent buffers
+	BufferStrategy m_Strategy;
+
+	unsigned char* m_Mapped;	//the whole persistent storage
+	unsigned int m_FrameCount;
+	unsigned int m_Frame;
+	void* m_Fences[MaxFrames];	//GLsync of the last frame that used each region
+	unsigned int m_Stalls;
+
+	BufferPool* m_Pool;			//nullptr when the buffer is our own
+	unsigned int m_Allocation;
+public:
+	BufferStorage(unsigned int target, const void* data, unsigned int size, BufferStrategy strategy, unsigned int frames);
+	//size bytes of the pool, a multiple of its element size. The pool must outlive this storage, the destructor
+	//gives the range back to it. If the pool has no room IsValid is false, the size is 0 and updates do nothing.
+	BufferStorage(BufferPool& pool, const void* data, unsigned int size);
+	~BufferStorage();
+
+	void Bind() const;
+	void UnBind() const;
+
+	//writes size bytes at offset (inside the current frame region for persistent buffers).
+	void Update(unsigned int offset, const void* data, unsigned int size);
+
+	void* BeginFrame();
+	void EndFrame();
+	inline unsigned int GetFrameOffset() const { return m_Frame * m_Size; }
+	inline unsigned int GetStalls() const { return m_Stalls; } //times BeginFrame had to wait for the GPU
+
+	//where the data starts in the buffer: 0 unless it's in a pool. GetFirstElement is the same in elements of the pool.
+	unsigned int GetOffset() const;
+	unsigned int GetFirstElement() const;
+	inline BufferPool* GetPool() const { return m_Pool; }
+	bool IsValid() const;
+
+	inline unsigned int GetSize() const { return m_Size; }
+	inline BufferStrategy GetStrategy() const { return m_Strategy; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+};
@@ -0,0 +1,56 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+Frustum Frustum::FromMatrix(const Mat4& viewProjection)
+{
+    const float* m = viewProjection.m;
+
+    //row i of the column major matrix is m[i], m[i + 4], m[i + 8], m[i + 12].
+    //the planes are the fourth row plus or minus each of the other three.
+    Frustum frustum;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            float sign = side == 0 ? 1.0f : -1.0f;
+            Vec4& plane = frustum.Planes[axis * 2 + side];
+
+            plane.x = m[3] + sign * m[axis];
+            plane.y = m[7] + sign * m[axis + 4];
+            plane.z = m[11] + sign * m[axis + 8];
+            plane.w = m[15] + sign * m[axis + 12];
+
+            float length = Length({ plane.x, plane.y, plane.z });
+            plane.x /= length;
+            plane.y /= length;
+            plane.z /= length;
+            plane.w /= length;
+        }
+    }
+    return frustum;
+}
+
+bool Frustum::IntersectsSphere(const Vec3& center, float radius) const
+{
+    for (int i = 0; i < PlaneCount; i++) {
+        const Vec4& plane = Planes[i];
+        if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::IntersectsBox(const Vec3& center, const Vec3& extent) const
+{
+    for (int i = 0; i < PlaneCount; i++) {
+        const Vec4& plane = Planes[i];
+
+        //the distance of the center and how far the box reaches towards the plane
+        float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        float reach = std::fabs(plane.x) * extent.x + std::fabs(plane.y) * extent.y + std::fabs(plane.z) * extent.z;
+        if (distance + reach < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Math.h"
+
+/*
+* The six planes of a view frustum. A point p is inside a plane when
+* dot(Normal, p) + Distance >= 0, the normals point into the frustum.
+*/
+struct Frustum
+{
+	enum { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+	Vec4 Planes[PlaneCount];	//xyz the unit normal, w the distance
+
+	//the planes of a view projection matrix (Gribb and Hartmann), in the space the matrix takes its points from.
+	static Frustum FromMatrix(const Mat4& viewProjection);
+
+	//conservative: spheres near the corners may pass without touching the frustum.
+	bool IntersectsSphere(const Vec3& center, float radius) const;
+
+	//an axis aligned box given by its center and half its size, conservative like the sphere.
+	bool IntersectsBox(const Vec3& center, const Vec3& extent) const;
+};
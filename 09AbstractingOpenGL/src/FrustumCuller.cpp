@@ -0,0 +1,179 @@
+#include "FrustumCuller.h"
+#include "Frustum.h"
+#include "ThreadPool.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_CULLER_SSE2
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FRUSTUM_CULLER_AVX2
+#endif
+
+//boxes per piece when the work is split among threads.
+static const size_t PieceBoxes = 16384;
+
+unsigned int FrustumCuller::Add(const Vec3& min, const Vec3& max)
+{
+    m_CenterX.push_back(0.0f);
+    m_CenterY.push_back(0.0f);
+    m_CenterZ.push_back(0.0f);
+    m_ExtentX.push_back(0.0f);
+    m_ExtentY.push_back(0.0f);
+    m_ExtentZ.push_back(0.0f);
+
+    unsigned int id = GetCount() - 1;
+    Set(id, min, max);
+    return id;
+}
+
+void FrustumCuller::Set(unsigned int id, const Vec3& min, const Vec3& max)
+{
+    m_CenterX[id] = (min.x + max.x) * 0.5f;
+    m_CenterY[id] = (min.y + max.y) * 0.5f;
+    m_CenterZ[id] = (min.z + max.z) * 0.5f;
+    m_ExtentX[id] = (max.x - min.x) * 0.5f;
+    m_ExtentY[id] = (max.y - min.y) * 0.5f;
+    m_ExtentZ[id] = (max.z - min.z) * 0.5f;
+}
+
+void FrustumCuller::Clear()
+{
+    m_CenterX.clear();
+    m_CenterY.clear();
+    m_CenterZ.clear();
+    m_ExtentX.clear();
+    m_ExtentY.clear();
+    m_ExtentZ.clear();
+}
+
+/*
+* Writes the visible ids of [first, last) to output and returns how many. A box is out when, for some plane,
+* the distance of its center plus how far it reaches towards the plane is negative (see Frustum::IntersectsBox).
+* The SIMD loops write every id and only advance past the visible ones, so there are no branches per box.
+*/
+static size_t CullRange(const Frustum& frustum, const float* cx, const float* cy, const float* cz,
+    const float* ex, const float* ey, const float* ez, size_t first, size_t last, unsigned int* output)
+{
+    size_t count = 0;
+    size_t i = first;
+
+#ifdef FRUSTUM_CULLER_AVX2
+    __m256 planeX[Frustum::PlaneCount], planeY[Frustum::PlaneCount], planeZ[Frustum::PlaneCount], planeW[Frustum::PlaneCount];
+    __m256 absX[Frustum::PlaneCount], absY[Frustum::PlaneCount], absZ[Frustum::PlaneCount];
+    for (int p = 0; p < Frustum::PlaneCount; p++) {
+        const Vec4& plane = frustum.Planes[p];
+        planeX[p] = _mm256_set1_ps(plane.x);
+        planeY[p] = _mm256_set1_ps(plane.y);
+        planeZ[p] = _mm256_set1_ps(plane.z);
+        planeW[p] = _mm256_set1_ps(plane.w);
+        absX[p] = _mm256_set1_ps(std::fabs(plane.x));
+        absY[p] = _mm256_set1_ps(std::fabs(plane.y));
+        absZ[p] = _mm256_set1_ps(std::fabs(plane.z));
+    }
+
+    for (; i + 8 <= last; i += 8) {
+        __m256 centerX = _mm256_loadu_ps(cx + i), centerY = _mm256_loadu_ps(cy + i), centerZ = _mm256_loadu_ps(cz + i);
+        __m256 extentX = _mm256_loadu_ps(ex + i), extentY = _mm256_loadu_ps(ey + i), extentZ = _mm256_loadu_ps(ez + i);
+        __m256 outside = _mm256_setzero_ps();
+
+        for (int p = 0; p < Frustum::PlaneCount; p++) {
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(centerX, planeX[p]), _mm256_mul_ps(centerY, planeY[p]));
+            distance = _mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(centerZ, planeZ[p])), planeW[p]);
+            __m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(extentX, absX[p]), _mm256_mul_ps(extentY, absY[p])),
+                _mm256_mul_ps(extentZ, absZ[p]));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        unsigned int visible = ~(unsigned int)_mm256_movemask_ps(outside);
+        for (unsigned int k = 0; k < 8; k++) {
+            output[count] = (unsigned int)(i + k);
+            count += (visible >> k) & 1;
+        }
+    }
+#elif defined(FRUSTUM_CULLER_SSE2)
+    __m128 planeX[Frustum::PlaneCount], planeY[Frustum::PlaneCount], planeZ[Frustum::PlaneCount], planeW[Frustum::PlaneCount];
+    __m128 absX[Frustum::PlaneCount], absY[Frustum::PlaneCount], absZ[Frustum::PlaneCount];
+    for (int p = 0; p < Frustum::PlaneCount; p++) {
+        const Vec4& plane = frustum.Planes[p];
+        planeX[p] = _mm_set1_ps(plane.x);
+        planeY[p] = _mm_set1_ps(plane.y);
+        planeZ[p] = _mm_set1_ps(plane.z);
+        planeW[p] = _mm_set1_ps(plane.w);
+        absX[p] = _mm_set1_ps(std::fabs(plane.x));
+        absY[p] = _mm_set1_ps(std::fabs(plane.y));
+        absZ[p] = _mm_set1_ps(std::fabs(plane.z));
+    }
+
+    for (; i + 4 <= last; i += 4) {
+        __m128 centerX = _mm_loadu_ps(cx + i), centerY = _mm_loadu_ps(cy + i), centerZ = _mm_loadu_ps(cz + i);
+        __m128 extentX = _mm_loadu_ps(ex + i), extentY = _mm_loadu_ps(ey + i), extentZ = _mm_loadu_ps(ez + i);
+        __m128 outside = _mm_setzero_ps();
+
+        for (int p = 0; p < Frustum::PlaneCount; p++) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(centerX, planeX[p]), _mm_mul_ps(centerY, planeY[p]));
+            distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(centerZ, planeZ[p])), planeW[p]);
+            __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extentX, absX[p]), _mm_mul_ps(extentY, absY[p])),
+                _mm_mul_ps(extentZ, absZ[p]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+        }
+
+        unsigned int visible = ~(unsigned int)_mm_movemask_ps(outside);
+        for (unsigned int k = 0; k < 4; k++) {
+            output[count] = (unsigned int)(i + k);
+            count += (visible >> k) & 1;
+        }
+    }
+#endif
+
+    for (; i < last; i++) {
+        if (frustum.IntersectsBox({ cx[i], cy[i], cz[i] }, { ex[i], ey[i], ez[i] })) {
+            output[count++] = (unsigned int)i;
+        }
+    }
+    return count;
+}
+
+void FrustumCuller::Cull(const Frustum& frustum, std::vector<unsigned int>& visible, ThreadPool* pool)
+{
+    size_t count = m_CenterX.size();
+
+    //only grows, so the frames after the first don't touch the memory before culling.
+    if (m_Scratch.size() < count) {
+        m_Scratch.resize(count);
+    }
+    unsigned int* ids = m_Scratch.data();
+
+    const float* cx = m_CenterX.data();
+    const float* cy = m_CenterY.data();
+    const float* cz = m_CenterZ.data();
+    const float* ex = m_ExtentX.data();
+    const float* ey = m_ExtentY.data();
+    const float* ez = m_ExtentZ.data();
+
+    if (!pool || pool->GetThreadCount() == 1 || count <= PieceBoxes) {
+        size_t total = CullRange(frustum, cx, cy, cz, ex, ey, ez, 0, count, ids);
+        visible.assign(ids, ids + total);
+        return;
+    }
+
+    //every piece writes its ids at its own start, then we slide them down next to each other.
+    size_t pieces = (count + PieceBoxes - 1) / PieceBoxes;
+    m_PieceVisible.resize(pieces);
+
+    pool->ParallelFor(count, PieceBoxes, [&](size_t first, size_t last) {
+        m_PieceVisible[first / PieceBoxes] = (unsigned int)CullRange(frustum, cx, cy, cz, ex, ey, ez, first, last, ids + first);
+    });
+
+    size_t total = m_PieceVisible[0];
+    for (size_t piece = 1; piece < pieces; piece++) {
+        memmove(ids + total, ids + piece * PieceBoxes, m_PieceVisible[piece] * sizeof(unsigned int));
+        total += m_PieceVisible[piece];
+    }
+    visible.assign(ids, ids + total);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Math.h"
+
+#include <vector>
+
+struct Frustum;
+class ThreadPool;
+
+/*
+* The bounding boxes of many objects, kept as separate arrays of centers and extents (structure of
+* arrays) so the culling loop tests 8 boxes at once with AVX2, or 4 with SSE2.
+*
+*   unsigned int id = culler.Add(min, max);    //once per object, ids are 0, 1, 2...
+*   culler.Cull(frustum, visible, &pool);      //every frame
+*   for (unsigned int id : visible) { ... }    //fill the instance buffer or the batch
+*/
+class FrustumCuller
+{
+private:
+	std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+	std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;	//half the size of the box
+	std::vector<unsigned int> m_Scratch;					//room for every id, Cull writes here first
+	std::vector<unsigned int> m_PieceVisible;				//visible boxes of each piece of a threaded Cull
+public:
+	unsigned int Add(const Vec3& min, const Vec3& max);
+	void Set(unsigned int id, const Vec3& min, const Vec3& max);
+	void Clear();
+
+	/*
+	* Replaces visible with the ids of the boxes that intersect the frustum, in increasing order.
+	* With a pool the boxes are split among its threads.
+	*/
+	void Cull(const Frustum& frustum, std::vector<unsigned int>& visible, ThreadPool* pool = nullptr);
+
+	inline unsigned int GetCount() const { return (unsigned int)m_CenterX.size(); }
+};
@@ -0,0 +1,311 @@
+#include "GLState.h"
+#include "Renderer.h"
+
+#include <unordered_map>
+
+//a value no object id can have, so the first call of each kind always reaches the driver.
+static const unsigned int Unknown = 0xFFFFFFFF;
+
+struct TextureBinding
+{
+    unsigned int target;
+    unsigned int texture;
+};
+
+struct CachedState
+{
+    unsigned int program = Unknown;
+    unsigned int vao = Unknown;
+    unsigned int arrayBuffer = Unknown;
+    unsigned int elementBuffer = Unknown;
+    unsigned int otherBuffers[8] = { Unknown, Unknown, Unknown, Unknown, Unknown, Unknown, Unknown, Unknown };
+    unsigned int uniformBindings[GLState::MaxBufferBindings];
+    unsigned int storageBindings[GLState::MaxBufferBindings];
+    unsigned int activeTexture = Unknown;
+    TextureBinding textures[GLState::MaxTextureUnits];
+    int blend = -1;
+    unsigned int blendSource = Unknown;
+    unsigned int blendDestination = Unknown;
+    int depthTest = -1;
+    unsigned int depthFunc = Unknown;
+    int depthMask = -1;
+
+    //the element buffer binding is part of the vertex array object, so we remember it per VAO.
+    std::unordered_map<unsigned int, unsigned int> vaoElementBuffers;
+
+    CachedState()
+    {
+        for (TextureBinding& binding : textures) {
+            binding = { Unknown, Unknown };
+        }
+        for (unsigned int i = 0; i < GLState::MaxBufferBindings; i++) {
+            uniformBindings[i] = Unknown;
+            storageBindings[i] = Unknown;
+        }
+    }
+};
+
+static CachedState s_State;
+static GLState::Stats s_Stats = { 0, 0 };
+
+//the targets we shadow apart from the array and element buffers.
+static const unsigned int OtherBufferTargets[8] = {
+    GL_UNIFORM_BUFFER,
+    GL_COPY_READ_BUFFER,
+    GL_COPY_WRITE_BUFFER,
+    GL_PIXEL_PACK_BUFFER,
+    GL_PIXEL_UNPACK_BUFFER,
+    GL_TEXTURE_BUFFER,
+    GL_DRAW_INDIRECT_BUFFER,
+    GL_SHADER_STORAGE_BUFFER
+};
+
+//returns the shadow slot of target or nullptr if we don't track it.
+static unsigned int* BufferSlot(unsigned int target)
+{
+    if (target == GL_ARRAY_BUFFER) {
+        return &s_State.arrayBuffer;
+    }
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        return &s_State.elementBuffer;
+    }
+    for (unsigned int i = 0; i < 8; i++) {
+        if (OtherBufferTargets[i] == target) {
+            return &s_State.otherBuffers[i];
+        }
+    }
+    return nullptr;
+}
+
+//true if value is already current. Otherwise it records the new value and counts an issued call.
+template<typename T>
+static bool IsCurrent(T& shadow, T value)
+{
+    if (shadow == value) {
+        s_Stats.skipped++;
+        return true;
+    }
+    shadow = value;
+    s_Stats.issued++;
+    return false;
+}
+
+void GLState::UseProgram(unsigned int program)
+{
+    if (!IsCurrent(s_State.program, program)) {
+        GLCall(glUseProgram(program));
+    }
+}
+
+void GLState::BindVertexArray(unsigned int vao)
+{
+    if (IsCurrent(s_State.vao, vao)) {
+        return;
+    }
+
+    GLCall(glBindVertexArray(vao));
+
+    auto it = s_State.vaoElementBuffers.find(vao);
+    s_State.elementBuffer = it != s_State.vaoElementBuffers.end() ? it->second : Unknown;
+}
+
+void GLState::BindBuffer(unsigned int target, unsigned int buffer)
+{
+    unsigned int* slot = BufferSlot(target);
+    if (!slot) {
+        s_Stats.issued++;
+        GLCall(glBindBuffer(target, buffer));
+        return;
+    }
+
+    if (IsCurrent(*slot, buffer)) {
+        return;
+    }
+
+    GLCall(glBindBuffer(target, buffer));
+
+    if (target == GL_ELEMENT_ARRAY_BUFFER && s_State.vao != Unknown) {
+        s_State.vaoElementBuffers[s_State.vao] = buffer;
+    }
+}
+
+void GLState::BindBufferBase(unsigned int target, unsigned int index, unsigned int buffer)
+{
+    unsigned int* indexed = nullptr;
+    if (target == GL_UNIFORM_BUFFER && index < MaxBufferBindings) {
+        indexed = &s_State.uniformBindings[index];
+    }
+    else if (target == GL_SHADER_STORAGE_BUFFER && index < MaxBufferBindings) {
+        indexed = &s_State.storageBindings[index];
+    }
+
+    if (indexed && IsCurrent(*indexed, buffer)) {
+        return;
+    }
+    if (!indexed) {
+        s_Stats.issued++;
+    }
+
+    GLCall(glBindBufferBase(target, index, buffer));
+
+    unsigned int* generic = BufferSlot(target);
+    if (generic) {
+        *generic = buffer;
+    }
+}
+
+void GLState::BindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+{
+    ASSERT(unit < MaxTextureUnits);
+
+    TextureBinding& binding = s_State.textures[unit];
+    if (binding.target == target && binding.texture == texture) {
+        s_Stats.skipped++;
+        return;
+    }
+
+    if (s_State.activeTexture != unit) {
+        s_State.activeTexture = unit;
+        s_Stats.issued++;
+        GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+    }
+
+    binding = { target, texture };
+    s_Stats.issued++;
+    GLCall(glBindTexture(target, texture));
+}
+
+void GLState::SetBlend(bool enabled)
+{
+    if (!IsCurrent(s_State.blend, (int)enabled)) {
+        if (enabled) {
+            GLCall(glEnable(GL_BLEND));
+        }
+        else {
+            GLCall(glDisable(GL_BLEND));
+        }
+    }
+}
+
+void GLState::SetBlendFunc(unsigned int source, unsigned int destination)
+{
+    if (s_State.blendSource == source && s_State.blendDestination == destination) {
+        s_Stats.skipped++;
+        return;
+    }
+
+    s_State.blendSource = source;
+    s_State.blendDestination = destination;
+    s_Stats.issued++;
+    GLCall(glBlendFunc(source, destination));
+}
+
+void GLState::SetDepthTest(bool enabled)
+{
+    if (!IsCurrent(s_State.depthTest, (int)enabled)) {
+        if (enabled) {
+            GLCall(glEnable(GL_DEPTH_TEST));
+        }
+        else {
+            GLCall(glDisable(GL_DEPTH_TEST));
+        }
+    }
+}
+
+void GLState::SetDepthFunc(unsigned int func)
+{
+    if (!IsCurrent(s_State.depthFunc, func)) {
+        GLCall(glDepthFunc(func));
+    }
+}
+
+void GLState::SetDepthMask(bool enabled)
+{
+    if (!IsCurrent(s_State.depthMask, (int)enabled)) {
+        GLCall(glDepthMask(enabled ? GL_TRUE : GL_FALSE));
+    }
+}
+
+void GLState::DeleteProgram(unsigned int program)
+{
+    //deleting the current program only flags it, it stays in use until another one is bound, so the shadow is still right.
+    GLCall(glDeleteProgram(program));
+}
+
+void GLState::DeleteVertexArray(unsigned int vao)
+{
+    GLCall(glDeleteVertexArrays(1, &vao));
+
+    s_State.vaoElementBuffers.erase(vao);
+    if (s_State.vao == vao) {
+        //the driver falls back to the default vertex array.
+        s_State.vao = 0;
+        auto it = s_State.vaoElementBuffers.find(0);
+        s_State.elementBuffer = it != s_State.vaoElementBuffers.end() ? it->second : Unknown;
+    }
+}
+
+void GLState::DeleteBuffer(unsigned int buffer)
+{
+    GLCall(glDeleteBuffers(1, &buffer));
+
+    //the driver unbinds a deleted buffer from every binding point of the current context.
+    if (s_State.arrayBuffer == buffer) {
+        s_State.arrayBuffer = 0;
+    }
+    if (s_State.elementBuffer == buffer) {
+        s_State.elementBuffer = 0;
+    }
+    for (unsigned int& slot : s_State.otherBuffers) {
+        if (slot == buffer) {
+            slot = 0;
+        }
+    }
+    for (unsigned int i = 0; i < MaxBufferBindings; i++) {
+        if (s_State.uniformBindings[i] == buffer) {
+            s_State.uniformBindings[i] = 0;
+        }
+        if (s_State.storageBindings[i] == buffer) {
+            s_State.storageBindings[i] = 0;
+        }
+    }
+
+    //only the current VAO is affected, for the others we can't know any more.
+    for (auto it = s_State.vaoElementBuffers.begin(); it != s_State.vaoElementBuffers.end();) {
+        if (it->second == buffer) {
+            it = s_State.vaoElementBuffers.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    if (s_State.elementBuffer == 0 && s_State.vao != Unknown) {
+        s_State.vaoElementBuffers[s_State.vao] = 0;
+    }
+}
+
+void GLState::DeleteTexture(unsigned int texture)
+{
+    GLCall(glDeleteTextures(1, &texture));
+
+    for (TextureBinding& binding : s_State.textures) {
+        if (binding.texture == texture) {
+            binding.texture = 0;
+        }
+    }
+}
+
+void GLState::Invalidate()
+{
+    s_State = CachedState();
+}
+
+GLState::Stats GLState::GetStats()
+{
+    return s_Stats;
+}
+
+void GLState::ResetStats()
+{
+    s_Stats = { 0, 0 };
+}
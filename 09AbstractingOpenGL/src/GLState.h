@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+* Shadows the bindings and render state of the current context so the abstraction classes
+* only talk to the driver when something actually changes.
+* Everything that binds through here must also delete through here, otherwise the shadow
+* copy could keep an id the driver has already unbound. After raw GL calls that change
+* any of this state call Invalidate().
+*/
+class GLState
+{
+public:
+	static const unsigned int MaxTextureUnits = 32;
+	static const unsigned int MaxBufferBindings = 16; //indexed uniform and storage bindings we shadow
+
+	struct Stats
+	{
+		unsigned long long issued;	//calls that reached the driver
+		unsigned long long skipped;	//redundant calls we dropped
+	};
+
+	static void UseProgram(unsigned int program);
+	static void BindVertexArray(unsigned int vao);
+	static void BindBuffer(unsigned int target, unsigned int buffer);
+	//binds to an indexed binding point (uniform or storage blocks), which also changes the generic binding of target.
+	static void BindBufferBase(unsigned int target, unsigned int index, unsigned int buffer);
+	static void BindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+
+	static void SetBlend(bool enabled);
+	static void SetBlendFunc(unsigned int source, unsigned int destination);
+	static void SetDepthTest(bool enabled);
+	static void SetDepthFunc(unsigned int func);
+	static void SetDepthMask(bool enabled);
+
+	static void DeleteProgram(unsigned int program);
+	static void DeleteVertexArray(unsigned int vao);
+	static void DeleteBuffer(unsigned int buffer);
+	static void DeleteTexture(unsigned int texture);
+
+	//forgets everything, the next call of each kind goes to the driver.
+	static void Invalidate();
+
+	static Stats GetStats();
+	static void ResetStats();
+};
@@ -0,0 +1,184 @@
+#include "GpuProfiler.h"
+#include "Renderer.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+GpuProfiler::GpuProfiler(unsigned int maxZonesPerFrame, unsigned int historySize)
+    : m_MaxZonesPerFrame(maxZonesPerFrame), m_HistorySize(historySize), m_FrameIndex(0), m_DroppedFrames(0)
+{
+    //all the query objects are created up front, the frame loop only reuses them.
+    for (Frame& frame : m_Frames) {
+        frame.queries.resize(maxZonesPerFrame * 2);
+        GLCall(glGenQueries((GLsizei)frame.queries.size(), frame.queries.data()));
+        frame.entries.reserve(maxZonesPerFrame);
+        frame.lastQuery = 0;
+        frame.pending = false;
+    }
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    for (Frame& frame : m_Frames) {
+        GLCall(glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data()));
+    }
+}
+
+unsigned int GpuProfiler::FindZone(const char* name)
+{
+    //there are only a handful of zones and the names are usually literals, so we compare the pointers first.
+    for (unsigned int i = 0; i < m_Zones.size(); i++) {
+        if (m_Zones[i].name == name || strcmp(m_Zones[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    m_Zones.push_back({ name, std::vector<double>(m_HistorySize, 0.0), 0, 0 });
+    return (unsigned int)m_Zones.size() - 1;
+}
+
+/*
+* Reads the results of a frame if the GPU has finished it. It never blocks.
+*/
+bool GpuProfiler::Collect(Frame& frame)
+{
+    if (!frame.pending) {
+        return true;
+    }
+
+    //queries complete in the order they were issued, so if the last one is available all of them are.
+    if (!frame.entries.empty()) {
+        GLuint available = GL_FALSE;
+        GLCall(glGetQueryObjectuiv(frame.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available));
+        if (!available) {
+            return false;
+        }
+    }
+
+    for (const Entry& entry : frame.entries) {
+        if (!entry.ended) {
+            continue;
+        }
+
+        GLuint64 begin, end;
+        GLCall(glGetQueryObjectui64v(entry.beginQuery, GL_QUERY_RESULT, &begin));
+        GLCall(glGetQueryObjectui64v(entry.endQuery, GL_QUERY_RESULT, &end));
+
+        Zone& zone = m_Zones[entry.zone];
+        zone.history[zone.next] = (end - begin) / 1000000.0;
+        zone.next = (zone.next + 1) % m_HistorySize;
+        zone.samples++;
+    }
+
+    frame.entries.clear();
+    frame.pending = false;
+    return true;
+}
+
+void GpuProfiler::BeginFrame()
+{
+    //we harvest every frame that is ready, oldest first.
+    for (unsigned int i = 1; i <= FrameLatency; i++) {
+        if (!Collect(m_Frames[(m_FrameIndex + i) % FrameLatency])) {
+            break;
+        }
+    }
+
+    //if the frame we are about to reuse still isn't ready we lose it rather than wait for it.
+    Frame& frame = m_Frames[m_FrameIndex % FrameLatency];
+    if (frame.pending) {
+        frame.entries.clear();
+        frame.pending = false;
+        m_DroppedFrames++;
+    }
+}
+
+void GpuProfiler::EndFrame()
+{
+    Frame& frame = m_Frames[m_FrameIndex % FrameLatency];
+    frame.pending = !frame.entries.empty();
+    m_FrameIndex++;
+}
+
+int GpuProfiler::BeginZone(const char* name)
+{
+    Frame& frame = m_Frames[m_FrameIndex % FrameLatency];
+    if (frame.entries.size() >= m_MaxZonesPerFrame) {
+        return -1;
+    }
+
+    unsigned int slot = (unsigned int)frame.entries.size();
+    Entry entry = { FindZone(name), frame.queries[slot * 2], frame.queries[slot * 2 + 1], false };
+    frame.entries.push_back(entry);
+
+    //timestamps rather than GL_TIME_ELAPSED because elapsed queries can't be nested.
+    GLCall(glQueryCounter(entry.beginQuery, GL_TIMESTAMP));
+    frame.lastQuery = entry.beginQuery;
+    return (int)slot;
+}
+
+void GpuProfiler::EndZone(int slot)
+{
+    if (slot < 0) {
+        return;
+    }
+
+    Frame& frame = m_Frames[m_FrameIndex % FrameLatency];
+    Entry& entry = frame.entries[slot];
+    GLCall(glQueryCounter(entry.endQuery, GL_TIMESTAMP));
+    frame.lastQuery = entry.endQuery;
+    entry.ended = true;
+}
+
+bool GpuProfiler::GetZoneStats(const char* name, ZoneStats& stats) const
+{
+    for (const Zone& zone : m_Zones) {
+        if (strcmp(zone.name, name) != 0) {
+            continue;
+        }
+
+        unsigned int count = std::min(zone.samples, m_HistorySize);
+        std::vector<double> sorted(zone.history.begin(), zone.history.begin() + count);
+
+        stats.name = zone.name;
+        stats.samples = zone.samples;
+        stats.averageMs = 0.0;
+        stats.p99Ms = 0.0;
+        stats.lastMs = count ? zone.history[(zone.next + m_HistorySize - 1) % m_HistorySize] : 0.0;
+
+        if (count) {
+            for (double sample : sorted) {
+                stats.averageMs += sample;
+            }
+            stats.averageMs /= count;
+
+            size_t index = (size_t)(0.99 * (count - 1) + 0.5);
+            std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+            stats.p99Ms = sorted[index];
+        }
+        return true;
+    }
+    return false;
+}
+
+std::vector<GpuProfiler::ZoneStats> GpuProfiler::GetAllZoneStats() const
+{
+    std::vector<ZoneStats> all(m_Zones.size());
+    for (size_t i = 0; i < m_Zones.size(); i++) {
+        GetZoneStats(m_Zones[i].name, all[i]);
+    }
+    return all;
+}
+
+void GpuProfiler::Print(std::ostream& stream) const
+{
+    for (const ZoneStats& stats : GetAllZoneStats()) {
+        stream << "GPU " << stats.name << ": avg " << stats.averageMs << " ms, p99 " << stats.p99Ms
+            << " ms (" << stats.samples << " samples)" << std::endl;
+    }
+
+    if (m_DroppedFrames) {
+        stream << "GPU profiler dropped " << m_DroppedFrames << " frames that weren't ready in time" << std::endl;
+    }
+}
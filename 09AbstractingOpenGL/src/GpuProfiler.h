@@ -0,0 +1,97 @@
+#pragma once
+
+#include <iosfwd>
+#include <vector>
+
+/*
+* Measures how long named zones of the frame take on the GPU with GL_TIMESTAMP queries.
+* The queries of a frame are read FrameLatency frames later and only if they are already
+* available, so the profiler never waits for the GPU. A frame whose results still aren't
+* ready when its queries are needed again is dropped.
+*
+*   profiler.BeginFrame();
+*   {
+*       GpuZone zone(profiler, "Draw");
+*       ...
+*   }
+*   profiler.EndFrame();
+*/
+class GpuProfiler
+{
+public:
+	static const unsigned int FrameLatency = 4;
+
+	struct ZoneStats
+	{
+		const char* name;
+		double averageMs;	//over the last samples (see historySize)
+		double p99Ms;
+		double lastMs;
+		unsigned int samples;
+	};
+
+private:
+	struct Zone
+	{
+		const char* name;
+		std::vector<double> history; //milliseconds, used as a ring
+		unsigned int next;
+		unsigned int samples;
+	};
+
+	struct Entry
+	{
+		unsigned int zone;
+		unsigned int beginQuery;
+		unsigned int endQuery;
+		bool ended;
+	};
+
+	struct Frame
+	{
+		std::vector<unsigned int> queries; //2 per zone
+		std::vector<Entry> entries;
+		unsigned int lastQuery;	//the one issued last, nested zones end after the ones inside them
+		bool pending;
+	};
+
+	Frame m_Frames[FrameLatency];
+	std::vector<Zone> m_Zones;
+	unsigned int m_MaxZonesPerFrame;
+	unsigned int m_HistorySize;
+	unsigned int m_FrameIndex;
+	unsigned int m_DroppedFrames;
+
+	unsigned int FindZone(const char* name);
+	bool Collect(Frame& frame);
+public:
+	GpuProfiler(unsigned int maxZonesPerFrame = 64, unsigned int historySize = 256);
+	~GpuProfiler();
+
+	void BeginFrame();
+	void EndFrame();
+
+	//returns the slot that has to be passed to EndZone. Zones can be nested.
+	int BeginZone(const char* name);
+	void EndZone(int slot);
+
+	bool GetZoneStats(const char* name, ZoneStats& stats) const;
+	std::vector<ZoneStats> GetAllZoneStats() const;
+	inline unsigned int GetDroppedFrames() const { return m_DroppedFrames; }
+
+	//prints one line per zone with its average and p99.
+	void Print(std::ostream& stream) const;
+};
+
+/*
+* Times its own scope on the GPU.
+*/
+class GpuZone
+{
+private:
+	GpuProfiler& m_Profiler;
+	int m_Slot;
+public:
+	GpuZone(GpuProfiler& profiler, const char* name) : m_Profiler(profiler), m_Slot(profiler.BeginZone(name)) {}
+	~GpuZone() { m_Profiler.EndZone(m_Slot); }
+};
@@ -0,0 +1,159 @@
+#include "HeadlessContext.h"
+#include "Renderer.h"
+
+#include <iostream>
+#include <cstring>
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext()
+    : m_Display(nullptr), m_Context(nullptr), m_Framebuffer(0), m_ColorBuffer(0), m_Width(0), m_Height(0)
+{
+}
+
+#if defined(__linux__)
+
+HeadlessContext::~HeadlessContext()
+{
+    if (m_Framebuffer) {
+        GLCall(glDeleteFramebuffers(1, &m_Framebuffer));
+        GLCall(glDeleteRenderbuffers(1, &m_ColorBuffer));
+    }
+
+    if (m_Display) {
+        eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+        if (m_Context) {
+            eglDestroyContext(m_Display, m_Context);
+        }
+
+        eglTerminate(m_Display);
+    }
+}
+
+bool HeadlessContext::Create(int width, int height)
+{
+    m_Width = width;
+    m_Height = height;
+
+    //we prefer the surfaceless platform because it doesn't need any display server at all.
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    EGLDisplay display = EGL_NO_DISPLAY;
+    if (getPlatformDisplay && clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        std::cout << "[EGL Error] (" << eglGetError() << "): failed to initialise the display" << std::endl;
+        return false;
+    }
+    m_Display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cout << "[EGL Error] (" << eglGetError() << "): desktop OpenGL is not available" << std::endl;
+        return false;
+    }
+
+    //EGL_SURFACE_TYPE defaults to windows, which the surfaceless platform doesn't have.
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) || numConfigs == 0) {
+        std::cout << "[EGL Error] (" << eglGetError() << "): no suitable config" << std::endl;
+        return false;
+    }
+
+    //the same OpenGL 3.3 Core profile we ask glfw for.
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#if GLCALL_MODE == GLCALL_MODE_DEBUG_OUTPUT
+        EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+        EGL_NONE
+    };
+
+    m_Context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (m_Context == EGL_NO_CONTEXT) {
+        std::cout << "[EGL Error] (" << eglGetError() << "): failed to create the context" << std::endl;
+        return false;
+    }
+
+    //no surface at all, everything is drawn into our framebuffer object.
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_Context)) {
+        std::cout << "[EGL Error] (" << eglGetError() << "): failed to make the context current" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool HeadlessContext::CreateFramebuffer()
+{
+    GLCall(glGenRenderbuffers(1, &m_ColorBuffer));
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_ColorBuffer));
+    GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_Width, m_Height));
+
+    GLCall(glGenFramebuffers(1, &m_Framebuffer));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer));
+    GLCall(glFramebufferRenderbuffer(
+        GL_FRAMEBUFFER,
+        GL_COLOR_ATTACHMENT0,   //where the colour goes
+        GL_RENDERBUFFER,
+        m_ColorBuffer
+    ));
+
+    GLenum status = GLCallValue(glCheckFramebufferStatus(GL_FRAMEBUFFER));
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "[OpenGL Error] framebuffer incomplete (" << status << ")" << std::endl;
+        return false;
+    }
+
+    GLCall(glViewport(0, 0, m_Width, m_Height));
+
+    //the framebuffer stays bound for the whole life of the context.
+    return true;
+}
+
+void HeadlessContext::SwapBuffers() const
+{
+    GLCall(glFlush());
+}
+
+#else
+
+HeadlessContext::~HeadlessContext()
+{
+}
+
+bool HeadlessContext::Create(int width, int height)
+{
+    std::cout << "Headless rendering needs EGL and it is only supported on Linux." << std::endl;
+    return false;
+}
+
+bool HeadlessContext::CreateFramebuffer()
+{
+    return false;
+}
+
+void HeadlessContext::SwapBuffers() const
+{
+}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+/*
+* An OpenGL context without a window. It uses EGL surfaceless (Mesa llvmpipe works fine)
+* and renders into a framebuffer object instead of the default framebuffer,
+* so it can run on hosts without a display or a GPU.
+*/
+class HeadlessContext
+{
+private:
+	void* m_Display;	//EGLDisplay
+	void* m_Context;	//EGLContext
+	unsigned int m_Framebuffer;
+	unsigned int m_ColorBuffer;
+	int m_Width;
+	int m_Height;
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	//creates the EGL context and makes it current. It must be called before glewInit.
+	bool Create(int width, int height);
+
+	//creates the FBO we render into. It must be called after glewInit.
+	bool CreateFramebuffer();
+
+	//there is nothing to present so we just flush the commands of this frame.
+	void SwapBuffers() const;
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+};
@@ -1,46 +1,172 @@
 #include "IndexBuffer.h"
 #include "Renderer.h"
+#include "BufferPool.h"
 
-IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
-    : m_Count(count)
+#include <vector>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INDEX_NARROWING_SSE2
+#endif
+
+static unsigned int IndexSize(unsigned int type)
 {
-    ASSERT(sizeof(unsigned int) == sizeof(GLuint));
+    return type == GL_UNSIGNED_BYTE ? 1 : type == GL_UNSIGNED_SHORT ? 2 : 4;
+}
+
+static unsigned int PoolIndexType(const BufferPool& pool)
+{
+    unsigned int size = pool.GetElementSize();
+    ASSERT(size == 1 || size == 2 || size == 4);
+    return size == 1 ? GL_UNSIGNED_BYTE : size == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+/*
+* The bitwise OR of all the indices. It is below 2^n exactly when the largest index is,
+* and unlike an unsigned max it only needs SSE2.
+*/
+static unsigned int IndexBits(const unsigned int* data, unsigned int count)
+{
+    unsigned int i = 0;
+    unsigned int bits = 0;
+
+#ifdef INDEX_NARROWING_SSE2
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_or_si128(acc0, _mm_loadu_si128((const __m128i*)(data + i)));
+        acc1 = _mm_or_si128(acc1, _mm_loadu_si128((const __m128i*)(data + i + 4)));
+    }
+    acc0 = _mm_or_si128(acc0, acc1);
+    acc0 = _mm_or_si128(acc0, _mm_shuffle_epi32(acc0, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc0 = _mm_or_si128(acc0, _mm_shuffle_epi32(acc0, _MM_SHUFFLE(2, 3, 0, 1)));
+    bits = (unsigned int)_mm_cvtsi128_si32(acc0);
+#endif
+
+    for (; i < count; i++) {
+        bits |= data[i];
+    }
+    return bits;
+}
+
+static unsigned int SmallestIndexType(const unsigned int* data, unsigned int count, BufferStrategy strategy)
+{
+    if (!data || strategy != BufferStrategy::Static) {
+        return GL_UNSIGNED_INT;
+    }
+
+    unsigned int bits = IndexBits(data, count);
+    return bits < 0x100 ? GL_UNSIGNED_BYTE : bits < 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+static void NarrowTo16(const unsigned int* source, unsigned short* destination, unsigned int count)
+{
+    unsigned int i = 0;
+
+#ifdef INDEX_NARROWING_SSE2
+    //SSE2 only packs with signed saturation, so we move [0, 65535] to [-32768, 32767] and flip the top bit back.
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+    for (; i + 8 <= count; i += 8) {
+        __m128i low = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(source + i)), bias32);
+        __m128i high = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(source + i + 4)), bias32);
+        __m128i packed = _mm_xor_si128(_mm_packs_epi32(low, high), bias16);
+        _mm_storeu_si128((__m128i*)(destination + i), packed);
+    }
+#endif
+
+    for (; i < count; i++) {
+        destination[i] = (unsigned short)source[i];
+    }
+}
+
+static void NarrowTo8(const unsigned int* source, unsigned char* destination, unsigned int count)
+{
+    unsigned int i = 0;
+
+#ifdef INDEX_NARROWING_SSE2
+    //values below 256 survive both packs untouched.
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(source + i)), _mm_loadu_si128((const __m128i*)(source + i + 4)));
+        __m128i b = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(source + i + 8)), _mm_loadu_si128((const __m128i*)(source + i + 12)));
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(a, b));
+    }
+#endif
+
+    for (; i < count; i++) {
+        destination[i] = (unsigned char)source[i];
+    }
+}
 
-    GLCall(glGenBuffers(
-        1,      //number of buffers
-        &m_RendererID //buffer id
-    ));
+//the indices converted to type, ready to be uploaded.
+static std::vector<unsigned char> NarrowIndices(const unsigned int* data, unsigned int count, unsigned int type)
+{
+    std::vector<unsigned char> narrowed;
+    if (!data) {
+        return narrowed;
+    }
 
-    GLCall(glBindBuffer(
-        GL_ELEMENT_ARRAY_BUFFER,
-        m_RendererID //we select this buffer to work on it next.
-    ));
+    narrowed.resize((size_t)count * IndexSize(type));
+    if (type == GL_UNSIGNED_BYTE) {
+        NarrowTo8(data, narrowed.data(), count);
+    }
+    else if (type == GL_UNSIGNED_SHORT) {
+        NarrowTo16(data, (unsigned short*)narrowed.data(), count);
+    }
+    else {
+        memcpy(narrowed.data(), data, narrowed.size());
+    }
+    return narrowed;
+}
 
-    GLCall(glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER,
-        count * sizeof(unsigned int),  //size in bytes
-        data,          //the data
-        GL_STATIC_DRAW      //a hint about the use we are going to make of it
-    ));
+IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count, BufferStrategy strategy, unsigned int frames)
+    : m_Count(count),
+      m_Type(SmallestIndexType(data, count, strategy)),
+      m_Storage(GL_ELEMENT_ARRAY_BUFFER, NarrowIndices(data, count, m_Type).data(), count * IndexSize(m_Type), strategy, frames)
+{
+    ASSERT(sizeof(unsigned int) == sizeof(GLuint));
 }
 
-IndexBuffer::~IndexBuffer()
+IndexBuffer::IndexBuffer(BufferPool& pool, const unsigned int* data, unsigned int count)
+    : m_Count(count),
+      m_Type(PoolIndexType(pool)),
+      m_Storage(pool, NarrowIndices(data, count, m_Type).data(), count * IndexSize(m_Type))
 {
-    GLCall(glDeleteBuffers(1, &m_RendererID));
+    ASSERT(!data || m_Type == GL_UNSIGNED_INT || IndexBits(data, count) < (m_Type == GL_UNSIGNED_BYTE ? 0x100u : 0x10000u));
+
+    //the pool was full, draws of it draw nothing.
+    if (!m_Storage.IsValid()) {
+        m_Count = 0;
+    }
 }
 
 void IndexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(
-        GL_ELEMENT_ARRAY_BUFFER,
-        m_RendererID //we select this buffer to work on it next.
-    ));
+    m_Storage.Bind();
 }
 
 void IndexBuffer::UnBind() const
 {
-    GLCall(glBindBuffer(
-        GL_ELEMENT_ARRAY_BUFFER,
-        0 //to unbind
-    ));
+    m_Storage.UnBind();
+}
+
+void IndexBuffer::Update(unsigned int first, const unsigned int* data, unsigned int count)
+{
+    ASSERT(first + count <= m_Count);
+
+    if (m_Type == GL_UNSIGNED_INT) {
+        m_Storage.Update(first * sizeof(unsigned int), data, count * sizeof(unsigned int));
+        return;
+    }
+
+    ASSERT(IndexBits(data, count) < (m_Type == GL_UNSIGNED_BYTE ? 0x100u : 0x10000u));
+
+    std::vector<unsigned char> narrowed = NarrowIndices(data, count, m_Type);
+    m_Storage.Update(first * IndexSize(m_Type), narrowed.data(), (unsigned int)narrowed.size());
+}
+
+unsigned int IndexBuffer::GetIndexSize() const
+{
+    return IndexSize(m_Type);
 }
@@ -1,16 +1,46 @@
 #pragma once
 
+#include "BufferStorage.h"
+
+/*
+* Static index buffers look at their largest index and store 8 or 16 bit indices when they fit.
+* Draw calls take the type from GetType. Buffers with any other strategy keep 32 bit indices
+* because their contents change after construction.
+* Index buffers in a BufferPool use the pool's element size, 1, 2 or 4 bytes.
+*/
 class IndexBuffer
 {
 private:
-	unsigned int m_RendererID;
 	unsigned int m_Count;
+	unsigned int m_Type;	//GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	BufferStorage m_Storage;
 public:
-	IndexBuffer(const unsigned int* data, unsigned int count);
-	~IndexBuffer();
+	//see BufferStorage for the strategies. frames only matters for BufferStrategy::Persistent.
+	IndexBuffer(const unsigned int* data, unsigned int count, BufferStrategy strategy = BufferStrategy::Static, unsigned int frames = 3);
+	//count indices in a range of the pool, which must outlive it. They must fit in its element size.
+	IndexBuffer(BufferPool& pool, const unsigned int* data, unsigned int count);
 
 	void Bind() const;
 	void UnBind() const;
 
+	//replaces count indices starting at first with the strategy of this buffer. They must fit in GetType.
+	void Update(unsigned int first, const unsigned int* data, unsigned int count);
+
+	//persistent buffers only, see BufferStorage
+	inline void* BeginFrame() { return m_Storage.BeginFrame(); }
+	inline void EndFrame() { m_Storage.EndFrame(); }
+	inline unsigned int GetFrameOffset() const { return m_Storage.GetFrameOffset(); }
+
+	//where the indices start in the buffer, in indices and in bytes. 0 if it isn't in a pool.
+	inline unsigned int GetFirstIndex() const { return m_Storage.GetFirstElement(); }
+	inline unsigned int GetOffset() const { return m_Storage.GetOffset(); }
+
+	//false when it was made in a pool that had no room for it. Don't draw it then.
+	inline bool IsValid() const { return m_Storage.IsValid(); }
+
+	inline BufferStrategy GetStrategy() const { return m_Storage.GetStrategy(); }
+	inline unsigned int GetRendererID() const { return m_Storage.GetRendererID(); }
 	inline unsigned int GetCount() const { return m_Count; }
-};
\ No newline at end of file
+	inline unsigned int GetType() const { return m_Type; }
+	unsigned int GetIndexSize() const; //bytes per index
+};
@@ -0,0 +1,58 @@
+#include "IndirectCommandBuffer.h"
+#include "Renderer.h"
+#include "GLState.h"
+
+IndirectCommandBuffer::IndirectCommandBuffer(unsigned int capacity)
+    : m_Capacity(capacity > 0 ? capacity : 1), m_Dirty(false)
+{
+    ASSERT(GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect);
+
+    m_Commands.reserve(m_Capacity);
+
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_RendererID);
+    GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER, m_Capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW));
+}
+
+IndirectCommandBuffer::~IndirectCommandBuffer()
+{
+    GLState::DeleteBuffer(m_RendererID);
+}
+
+void IndirectCommandBuffer::Clear()
+{
+    m_Commands.clear();
+    m_Dirty = true;
+}
+
+void IndirectCommandBuffer::Add(unsigned int count, unsigned int firstIndex, int baseVertex, unsigned int instanceCount, unsigned int baseInstance)
+{
+    m_Commands.push_back({ count, instanceCount, firstIndex, baseVertex, baseInstance });
+    m_Dirty = true;
+}
+
+void IndirectCommandBuffer::Add(const DrawElementsIndirectCommand& command)
+{
+    m_Commands.push_back(command);
+    m_Dirty = true;
+}
+
+void IndirectCommandBuffer::Bind()
+{
+    GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_RendererID);
+
+    if (!m_Dirty) {
+        return;
+    }
+
+    //we grow like a vector so rebuilding bigger scenes doesn't reallocate every frame.
+    while (m_Capacity < m_Commands.size()) {
+        m_Capacity *= 2;
+    }
+
+    //new storage every time, so we never wait for the GPU to finish reading the previous commands.
+    unsigned int size = (unsigned int)(m_Commands.size() * sizeof(DrawElementsIndirectCommand));
+    GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER, m_Capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW));
+    GLCall(glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, m_Commands.data()));
+    m_Dirty = false;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+//the layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+	unsigned int Count;			//indices of the draw
+	unsigned int InstanceCount;
+	unsigned int FirstIndex;	//in indices, not bytes
+	int BaseVertex;				//added to every index
+	unsigned int BaseInstance;	//first element of the per-instance attributes
+};
+
+/*
+* Records draws of sub-ranges of one IndexBuffer/VertexBuffer pair and keeps them in a GPU buffer,
+* so Renderer::DrawIndirect submits all of them with a single glMultiDrawElementsIndirect.
+*
+*   commands.Clear();
+*   commands.Add(mesh.IndexCount, mesh.FirstIndex, mesh.BaseVertex);  //for every mesh
+*   renderer.DrawIndirect(va, ib, shader, commands);
+*/
+class IndirectCommandBuffer
+{
+private:
+	std::vector<DrawElementsIndirectCommand> m_Commands;
+	unsigned int m_RendererID;
+	unsigned int m_Capacity;	//commands the GPU buffer can hold
+	bool m_Dirty;				//the GPU copy is out of date
+public:
+	IndirectCommandBuffer(unsigned int capacity = 1024);
+	~IndirectCommandBuffer();
+
+	void Clear();
+	void Add(unsigned int count, unsigned int firstIndex, int baseVertex = 0, unsigned int instanceCount = 1, unsigned int baseInstance = 0);
+	void Add(const DrawElementsIndirectCommand& command);
+
+	//binds the buffer to GL_DRAW_INDIRECT_BUFFER, uploading the commands first if they changed.
+	void Bind();
+
+	inline unsigned int GetCount() const { return (unsigned int)m_Commands.size(); }
+	inline const DrawElementsIndirectCommand* GetCommands() const { return m_Commands.data(); }
+};
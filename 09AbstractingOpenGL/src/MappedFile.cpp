@@ -0,0 +1,129 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path, Access access)
+    : m_Data(nullptr), m_Size(0), m_File(INVALID_HANDLE_VALUE), m_Mapping(nullptr), m_Open(false)
+{
+    m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_File, &size)) {
+        return;
+    }
+    m_Size = (size_t)size.QuadPart;
+    m_Open = true;
+
+    if (access == Access::Read) {
+        //if the file got shorter since we asked its size, we keep what was there.
+        m_Copy.resize(m_Size);
+        size_t done = 0;
+        DWORD read = 0;
+        while (done < m_Size && ReadFile(m_File, &m_Copy[done], (DWORD)(m_Size - done), &read, nullptr) && read > 0) {
+            done += read;
+        }
+        m_Copy.resize(done);
+        m_Size = done;
+        m_Data = done ? m_Copy.data() : nullptr;
+        return;
+    }
+
+    //a mapping of an empty file fails, but there is nothing to map anyway.
+    if (m_Size == 0) {
+        return;
+    }
+
+    m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_Mapping) {
+        m_Data = (const char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!m_Data) {
+        m_Size = 0;
+        m_Open = false;
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_Data && m_Copy.empty()) {
+        UnmapViewOfFile(m_Data);
+    }
+    if (m_Mapping) {
+        CloseHandle(m_Mapping);
+    }
+    if (m_File != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_File);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path, Access access)
+    : m_Data(nullptr), m_Size(0), m_Open(false)
+{
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) == 0) {
+        m_Size = (size_t)status.st_size;
+        m_Open = true;
+
+        if (access == Access::Read) {
+            //if the file got shorter since fstat, we keep what was there.
+            m_Copy.resize(m_Size);
+            size_t done = 0;
+            while (done < m_Size) {
+                ssize_t count = read(file, &m_Copy[done], m_Size - done);
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (count <= 0) {
+                    break;
+                }
+                done += (size_t)count;
+            }
+            m_Copy.resize(done);
+            m_Size = done;
+            m_Data = done ? m_Copy.data() : nullptr;
+        }
+        else if (m_Size > 0) {
+            void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (data == MAP_FAILED) {
+                m_Size = 0;
+                m_Open = false;
+            }
+            else {
+                m_Data = (const char*)data;
+            }
+        }
+    }
+
+    //the mapping keeps its own reference to the file.
+    close(file);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_Data && m_Copy.empty()) {
+        munmap((void*)m_Data, m_Size);
+    }
+}
+
+#endif
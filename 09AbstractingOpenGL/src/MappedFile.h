@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/*
+* A read only file mapped into memory. GetText views the pages the OS already has in its file
+* cache, nothing is read or copied until it is touched. The view is valid while the object lives.
+* Truncating the file on disk meanwhile is undefined (SIGBUS on POSIX), replace it instead.
+*
+* Access::Read reads the whole file into memory of its own instead. It's a copy, so nothing done
+* to the file afterwards shows in GetText: use it for files that may be being saved right now.
+*/
+class MappedFile
+{
+public:
+	enum class Access
+	{
+		Map,
+		Read
+	};
+private:
+	const char* m_Data;
+	size_t m_Size;
+	std::string m_Copy;	//the text with Access::Read, m_Data points into it
+#ifdef _WIN32
+	void* m_File;		//HANDLEs
+	void* m_Mapping;
+#endif
+	bool m_Open;
+public:
+	MappedFile(const std::string& path, Access access = Access::Map);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//false when the file couldn't be opened. Empty files are open with no text.
+	inline bool IsOpen() const { return m_Open; }
+	inline std::string_view GetText() const { return std::string_view(m_Data, m_Size); }
+};
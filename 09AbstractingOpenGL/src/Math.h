@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cmath>
+
+/*
+* Plain vector and matrix types with the same memory layout as their GLSL counterparts.
+* Matrices are column major, like OpenGL expects them.
+* Below them there are the few operations the culling code and the benchmarks need.
+*/
+struct Vec2
+{
+	float x, y;
+};
+
+struct Vec3
+{
+	float x, y, z;
+};
+
+struct Vec4
+{
+	float x, y, z, w;
+};
+
+struct Mat4
+{
+	float m[16];
+};
+
+inline Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline Vec3 operator*(const Vec3& a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+
+inline float Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3 Cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+inline float Length(const Vec3& v) { return std::sqrt(Dot(v, v)); }
+
+//v / |v|, or v itself if it is 0
+inline Vec3 Normalize(const Vec3& v)
+{
+	float length = Length(v);
+	return length > 0.0f ? v * (1.0f / length) : v;
+}
+
+//a * b, so b is applied first
+inline Mat4 Multiply(const Mat4& a, const Mat4& b)
+{
+	Mat4 result;
+	for (int column = 0; column < 4; column++) {
+		for (int row = 0; row < 4; row++) {
+			float sum = 0.0f;
+			for (int k = 0; k < 4; k++) {
+				sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+			}
+			result.m[column * 4 + row] = sum;
+		}
+	}
+	return result;
+}
+
+//like gluPerspective, fovY in radians
+inline Mat4 Perspective(float fovY, float aspect, float zNear, float zFar)
+{
+	float f = 1.0f / std::tan(fovY * 0.5f);
+	Mat4 result = {};
+	result.m[0] = f / aspect;
+	result.m[5] = f;
+	result.m[10] = (zFar + zNear) / (zNear - zFar);
+	result.m[11] = -1.0f;
+	result.m[14] = 2.0f * zFar * zNear / (zNear - zFar);
+	return result;
+}
+
+//like gluLookAt
+inline Mat4 LookAt(const Vec3& eye, const Vec3& target, const Vec3& up)
+{
+	Vec3 f = Normalize(target - eye);
+	Vec3 s = Normalize(Cross(f, up));
+	Vec3 u = Cross(s, f);
+
+	Mat4 result = {};
+	result.m[0] = s.x; result.m[4] = s.y; result.m[8] = s.z;
+	result.m[1] = u.x; result.m[5] = u.y; result.m[9] = u.z;
+	result.m[2] = -f.x; result.m[6] = -f.y; result.m[10] = -f.z;
+	result.m[12] = -Dot(s, eye);
+	result.m[13] = -Dot(u, eye);
+	result.m[14] = Dot(f, eye);
+	result.m[15] = 1.0f;
+	return result;
+}
@@ -0,0 +1,523 @@
+#include "MeshOptimizer.h"
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+
+//for the timings of the report
+static double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//the cache Forsyth's scores model. Real GPUs are around 16-32 entries.
+static const unsigned int ForsythCacheSize = 32;
+static const unsigned int ForsythMaxValence = 32;
+
+//triangles per chunk when the mesh is split among threads.
+static const size_t ChunkTriangles = 1 << 16;
+
+/*
+* The scores of Tom Forsyth's "Linear-Speed Vertex Cache Optimisation". A vertex scores higher the more
+* recently it was used (but the last triangle's ones a bit less, to avoid strips going back and forth)
+* and the fewer triangles it has left (so we don't leave lonely triangles behind).
+*/
+struct ForsythScores
+{
+    float Cache[ForsythCacheSize + 1];        //by cache position + 1, 0 is not in the cache
+    float Valence[ForsythMaxValence + 1];    //by triangles left
+
+    ForsythScores()
+    {
+        Cache[0] = 0.0f;
+        for (unsigned int i = 0; i < ForsythCacheSize; i++) {
+            if (i < 3) {
+                Cache[i + 1] = 0.75f;
+            }
+            else {
+                float scaled = 1.0f - (float)(i - 3) / (ForsythCacheSize - 3);
+                Cache[i + 1] = std::pow(scaled, 1.5f);
+            }
+        }
+
+        Valence[0] = -1.0f; //no triangles left, it doesn't matter where it is anymore
+        for (unsigned int i = 1; i <= ForsythMaxValence; i++) {
+            Valence[i] = 2.0f / std::sqrt((float)i);
+        }
+    }
+
+    inline float Score(int cachePosition, unsigned int live) const
+    {
+        if (live == 0) {
+            return -1.0f;
+        }
+        return Cache[cachePosition + 1] + Valence[std::min(live, ForsythMaxValence)];
+    }
+};
+
+static const ForsythScores s_Forsyth;
+
+/*
+* Forsyth on one run of triangles. The vertices are renumbered locally first so the per vertex
+* arrays are as big as the chunk and not the whole mesh.
+*/
+static void OptimizeVertexCacheChunk(unsigned int* destination, const unsigned int* indices, size_t triangleCount)
+{
+    size_t indexCount = triangleCount * 3;
+
+    std::vector<unsigned int> vertices(indices, indices + indexCount);
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    size_t vertexCount = vertices.size();
+
+    std::vector<unsigned int> local(indexCount);
+    for (size_t i = 0; i < indexCount; i++) {
+        local[i] = (unsigned int)(std::lower_bound(vertices.begin(), vertices.end(), indices[i]) - vertices.begin());
+    }
+
+    //triangles of every vertex. The first live[v] entries of its range are the ones not emitted yet.
+    std::vector<unsigned int> live(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; i++) {
+        live[local[i]]++;
+    }
+
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) {
+        offsets[v + 1] = offsets[v] + live[v];
+    }
+
+    std::vector<unsigned int> adjacency(indexCount);
+    {
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; i++) {
+            adjacency[fill[local[i]]++] = (unsigned int)(i / 3);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        vertexScore[v] = s_Forsyth.Score(-1, live[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<char> emitted(triangleCount, 0);
+
+    int best = -1;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const unsigned int* triangle = &local[t * 3];
+        triangleScore[t] = vertexScore[triangle[0]] + vertexScore[triangle[1]] + vertexScore[triangle[2]];
+
+        if (triangleScore[t] > bestScore) {
+            bestScore = triangleScore[t];
+            best = (int)t;
+        }
+    }
+
+    unsigned int cache[ForsythCacheSize + 3];
+    unsigned int cacheCount = 0;
+    size_t cursor = 0; //every triangle before it has been emitted
+
+    for (size_t output = 0; output < triangleCount; output++) {
+        //nothing in the cache is connected to a triangle left, we take the next one in the input order.
+        if (best < 0) {
+            while (emitted[cursor]) {
+                cursor++;
+            }
+            best = (int)cursor;
+        }
+
+        const unsigned int* triangle = &local[best * 3];
+        memcpy(destination + output * 3, indices + best * 3, 3 * sizeof(unsigned int));
+        emitted[best] = 1;
+
+        //we take the triangle out of the live ones of its vertices.
+        for (unsigned int k = 0; k < 3; k++) {
+            unsigned int v = triangle[k];
+            unsigned int* triangles = &adjacency[offsets[v]];
+
+            for (unsigned int j = 0; j < live[v]; j++) {
+                if (triangles[j] == (unsigned int)best) {
+                    triangles[j] = triangles[live[v] - 1];
+                    break;
+                }
+            }
+            live[v]--;
+        }
+
+        //the triangle's vertices go to the front of the LRU cache and everything else moves back.
+        unsigned int newCache[ForsythCacheSize + 3];
+        unsigned int newCount = 0;
+
+        for (unsigned int k = 0; k < 3; k++) {
+            newCache[newCount++] = triangle[k];
+        }
+        for (unsigned int i = 0; i < cacheCount; i++) {
+            unsigned int v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                newCache[newCount++] = v;
+            }
+        }
+
+        for (unsigned int i = ForsythCacheSize; i < newCount; i++) {
+            cachePosition[newCache[i]] = -1;
+        }
+        for (unsigned int i = 0; i < newCount && i < ForsythCacheSize; i++) {
+            cachePosition[newCache[i]] = (int)i;
+        }
+
+        //the vertices that moved (including the ones that fell out) change score, and so do their triangles.
+        for (unsigned int i = 0; i < newCount; i++) {
+            unsigned int v = newCache[i];
+            float score = s_Forsyth.Score(cachePosition[v], live[v]);
+            float delta = score - vertexScore[v];
+
+            if (delta != 0.0f) {
+                vertexScore[v] = score;
+
+                const unsigned int* triangles = &adjacency[offsets[v]];
+                for (unsigned int j = 0; j < live[v]; j++) {
+                    triangleScore[triangles[j]] += delta;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCount, ForsythCacheSize);
+        memcpy(cache, newCache, cacheCount * sizeof(unsigned int));
+
+        //the next triangle is the best one touching the cache.
+        best = -1;
+        bestScore = -1.0f;
+        for (unsigned int i = 0; i < cacheCount; i++) {
+            unsigned int v = cache[i];
+            const unsigned int* triangles = &adjacency[offsets[v]];
+
+            for (unsigned int j = 0; j < live[v]; j++) {
+                unsigned int t = triangles[j];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = (int)t;
+                }
+            }
+        }
+    }
+}
+
+/*
+* Puts the triangles in breadth first order through shared vertices, so consecutive triangles are
+* close on the surface whatever order they came in. Cutting this order in chunks gives each thread
+* a patch of the mesh instead of triangles scattered all over it.
+*/
+static std::vector<unsigned int> ConnectedTriangleOrder(const unsigned int* indices, size_t indexCount, size_t vertexCount)
+{
+    size_t triangleCount = indexCount / 3;
+
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < indexCount; i++) {
+        offsets[indices[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        offsets[v + 1] += offsets[v];
+    }
+
+    std::vector<unsigned int> adjacency(indexCount);
+    {
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; i++) {
+            adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+        }
+    }
+
+    std::vector<char> visited(triangleCount, 0);
+    std::vector<unsigned int> order;
+    order.reserve(triangleCount);
+
+    //the order itself is the queue, head is the next triangle to expand.
+    size_t head = 0;
+    for (size_t seed = 0; seed < triangleCount; seed++) {
+        if (visited[seed]) {
+            continue;
+        }
+
+        visited[seed] = 1;
+        order.push_back((unsigned int)seed);
+
+        while (head < order.size()) {
+            const unsigned int* triangle = &indices[order[head++] * 3];
+
+            for (unsigned int k = 0; k < 3; k++) {
+                unsigned int v = triangle[k];
+                for (unsigned int j = offsets[v]; j < offsets[v + 1]; j++) {
+                    unsigned int t = adjacency[j];
+                    if (!visited[t]) {
+                        visited[t] = 1;
+                        order.push_back(t);
+                    }
+                }
+            }
+        }
+    }
+    return order;
+}
+
+VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+    //a vertex is in the FIFO if fewer than cacheSize vertices went in after it.
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    unsigned int timestamp = cacheSize + 1;
+    size_t misses = 0;
+
+    for (size_t i = 0; i < indexCount; i++) {
+        unsigned int v = indices[i];
+        if (timestamp - cacheTime[v] > cacheSize) {
+            cacheTime[v] = timestamp++;
+            misses++;
+        }
+    }
+
+    size_t used = 0;
+    for (size_t v = 0; v < vertexCount; v++) {
+        used += cacheTime[v] != 0;
+    }
+
+    VertexCacheStats stats;
+    stats.ACMR = indexCount ? (float)misses / (indexCount / 3) : 0.0f;
+    stats.ATVR = used ? (float)misses / used : 0.0f;
+    return stats;
+}
+
+void OptimizeVertexCache(unsigned int* destination, const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int threads)
+{
+    size_t triangleCount = indexCount / 3;
+
+    if (triangleCount <= ChunkTriangles) {
+        OptimizeVertexCacheChunk(destination, indices, triangleCount);
+        return;
+    }
+
+    std::vector<unsigned int> order = ConnectedTriangleOrder(indices, indexCount, vertexCount);
+    size_t chunkCount = (triangleCount + ChunkTriangles - 1) / ChunkTriangles;
+
+    //every chunk writes to its own range of destination, so the threads only share the chunk counter.
+    std::atomic<size_t> nextChunk(0);
+    auto worker = [&]() {
+        std::vector<unsigned int> chunkIndices;
+
+        for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+            size_t first = chunk * ChunkTriangles;
+            size_t count = std::min(ChunkTriangles, triangleCount - first);
+
+            chunkIndices.resize(count * 3);
+            for (size_t t = 0; t < count; t++) {
+                memcpy(&chunkIndices[t * 3], indices + order[first + t] * 3, 3 * sizeof(unsigned int));
+            }
+
+            OptimizeVertexCacheChunk(destination + first * 3, chunkIndices.data(), count);
+        }
+    };
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = (unsigned int)std::min((size_t)threads, chunkCount);
+
+    std::vector<std::thread> pool;
+    for (unsigned int i = 1; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+void OptimizeOverdraw(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+    const float* positions, size_t vertexCount, size_t positionStride, unsigned int positionComponents, float threshold)
+{
+    const unsigned int cacheSize = 16;
+    size_t triangleCount = indexCount / 3;
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    unsigned int timestamp = cacheSize + 1;
+
+    auto misses = [&](size_t t) {
+        unsigned int count = 0;
+        for (unsigned int k = 0; k < 3; k++) {
+            unsigned int v = indices[t * 3 + k];
+            if (timestamp - cacheTime[v] > cacheSize) {
+                cacheTime[v] = timestamp++;
+                count++;
+            }
+        }
+        return count;
+    };
+
+    //hard boundaries: the cache optimizer started over (all three vertices missed). The runs between them
+    //are cut again as soon as their ACMR is within threshold of the whole run's, with an empty cache each time.
+    std::vector<unsigned int> clusters;
+    {
+        std::vector<unsigned int> hard;
+        std::vector<unsigned char> triangleMisses(triangleCount);
+
+        for (size_t t = 0; t < triangleCount; t++) {
+            triangleMisses[t] = (unsigned char)misses(t);
+            if (t == 0 || triangleMisses[t] == 3) {
+                hard.push_back((unsigned int)t);
+            }
+        }
+        hard.push_back((unsigned int)triangleCount);
+
+        for (size_t h = 0; h + 1 < hard.size(); h++) {
+            size_t start = hard[h], end = hard[h + 1];
+
+            unsigned int runMisses = 0;
+            for (size_t t = start; t < end; t++) {
+                runMisses += triangleMisses[t];
+            }
+            float target = threshold * runMisses / (end - start);
+
+            size_t clusterStart = start;
+            unsigned int clusterMisses = 0;
+            timestamp += cacheSize + 1;
+
+            for (size_t t = start; t < end; t++) {
+                clusterMisses += misses(t);
+
+                if ((float)clusterMisses / (t + 1 - clusterStart) <= target && t + 1 < end) {
+                    clusters.push_back((unsigned int)clusterStart);
+                    clusterStart = t + 1;
+                    clusterMisses = 0;
+                    timestamp += cacheSize + 1;
+                }
+            }
+            clusters.push_back((unsigned int)clusterStart);
+        }
+    }
+    clusters.push_back((unsigned int)triangleCount);
+
+    size_t clusterCount = clusters.size() - 1;
+
+    auto position = [&](unsigned int v, float* p) {
+        const float* source = (const float*)((const char*)positions + v * positionStride);
+        p[0] = source[0];
+        p[1] = source[1];
+        p[2] = positionComponents > 2 ? source[2] : 0.0f;
+    };
+
+    //area weighted centroid and normal of every cluster, and the centroid of the whole mesh.
+    std::vector<float> centroids(clusterCount * 3), normals(clusterCount * 3);
+    float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c < clusterCount; c++) {
+        float centroid[3] = { 0.0f, 0.0f, 0.0f };
+        float normal[3] = { 0.0f, 0.0f, 0.0f };
+        float clusterArea = 0.0f;
+
+        for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+            float a[3], b[3], d[3];
+            position(indices[t * 3 + 0], a);
+            position(indices[t * 3 + 1], b);
+            position(indices[t * 3 + 2], d);
+
+            float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float e2[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (unsigned int k = 0; k < 3; k++) {
+                centroid[k] += (a[k] + b[k] + d[k]) / 3.0f * area;
+                normal[k] += n[k];
+            }
+            clusterArea += area;
+        }
+
+        for (unsigned int k = 0; k < 3; k++) {
+            meshCentroid[k] += centroid[k];
+            centroids[c * 3 + k] = clusterArea > 0.0f ? centroid[k] / clusterArea : 0.0f;
+        }
+        meshArea += clusterArea;
+
+        float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (unsigned int k = 0; k < 3; k++) {
+            normals[c * 3 + k] = length > 0.0f ? normal[k] / length : 0.0f;
+        }
+    }
+
+    for (unsigned int k = 0; k < 3; k++) {
+        meshCentroid[k] = meshArea > 0.0f ? meshCentroid[k] / meshArea : 0.0f;
+    }
+
+    //clusters facing away from the middle of the mesh are the ones in front, they go first.
+    std::vector<float> keys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        keys[c] = 0.0f;
+        for (unsigned int k = 0; k < 3; k++) {
+            keys[c] += (centroids[c * 3 + k] - meshCentroid[k]) * normals[c * 3 + k];
+        }
+    }
+
+    std::vector<unsigned int> sorted(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        sorted[c] = (unsigned int)c;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [&](unsigned int a, unsigned int b) { return keys[a] > keys[b]; });
+
+    size_t output = 0;
+    for (unsigned int c : sorted) {
+        size_t count = (clusters[c + 1] - clusters[c]) * 3;
+        memcpy(destination + output, indices + clusters[c] * 3, count * sizeof(unsigned int));
+        output += count;
+    }
+}
+
+size_t OptimizeVertexFetch(void* destination, unsigned int* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t vertexSize)
+{
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertexCount, unused);
+    size_t next = 0;
+
+    for (size_t i = 0; i < indexCount; i++) {
+        unsigned int v = indices[i];
+
+        if (remap[v] == unused) {
+            remap[v] = (unsigned int)next;
+            memcpy((char*)destination + next * vertexSize, (const char*)vertices + v * vertexSize, vertexSize);
+            next++;
+        }
+        indices[i] = remap[v];
+    }
+    return next;
+}
+
+MeshOptimizerReport OptimizeMesh(void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset, unsigned int positionComponents,
+    unsigned int* indices, size_t indexCount)
+{
+    MeshOptimizerReport report;
+    report.Before = AnalyzeVertexCache(indices, indexCount, vertexCount);
+
+    std::vector<unsigned int> scratch(indexCount);
+
+    auto start = std::chrono::steady_clock::now();
+    OptimizeVertexCache(scratch.data(), indices, indexCount, vertexCount);
+    report.CacheMilliseconds = MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    OptimizeOverdraw(indices, scratch.data(), indexCount, (const float*)((const char*)vertices + positionOffset),
+        vertexCount, vertexSize, positionComponents);
+    report.OverdrawMilliseconds = MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<char> copy((const char*)vertices, (const char*)vertices + vertexCount * vertexSize);
+    report.VertexCount = OptimizeVertexFetch(vertices, indices, indexCount, copy.data(), vertexCount, vertexSize);
+    report.FetchMilliseconds = MillisecondsSince(start);
+
+    report.After = AnalyzeVertexCache(indices, indexCount, report.VertexCount);
+    return report;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+* Reorders the triangles and vertices of an indexed mesh before it goes into an IndexBuffer and a
+* VertexBuffer, so the GPU transforms fewer vertices and reads them in order:
+*
+*   1. OptimizeVertexCache: Forsyth's algorithm, triangles that reuse recently transformed vertices go first.
+*   2. OptimizeOverdraw: cuts the result in clusters and sorts them so outward facing ones are drawn first.
+*   3. OptimizeVertexFetch: renumbers the vertices in the order the indices use them.
+*
+* OptimizeMesh runs the three of them in place.
+*/
+
+struct VertexCacheStats
+{
+	float ACMR;	//average cache miss ratio: transformed vertices per triangle. 0.5 is the best for a regular grid, 3 the worst
+	float ATVR;	//average transformed vertex ratio: transformed vertices per vertex. 1 is the best
+};
+
+//simulates a FIFO post-transform cache of cacheSize vertices.
+VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+
+//destination and indices can't overlap. threads 0 uses every core.
+void OptimizeVertexCache(unsigned int* destination, const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int threads = 0);
+
+/*
+* Keeps the cache friendly order inside each cluster. A cluster ends once its ACMR is within threshold
+* of what the whole run gets, so a bigger threshold means smaller clusters, less overdraw and more misses.
+* positions point to the first float of the position of vertex 0, positionStride is the size of a vertex in bytes
+* and positionComponents is 2 or 3 (2D positions lie on z = 0).
+*/
+void OptimizeOverdraw(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride, unsigned int positionComponents, float threshold = 1.05f);
+
+//copies the vertices to destination in the order they are first used and rewrites indices. Returns how many vertices are used.
+size_t OptimizeVertexFetch(void* destination, unsigned int* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t vertexSize);
+
+struct MeshOptimizerReport
+{
+	VertexCacheStats Before;
+	VertexCacheStats After;
+	size_t VertexCount;		//vertices left after the fetch remap
+	double CacheMilliseconds;
+	double OverdrawMilliseconds;
+	double FetchMilliseconds;
+};
+
+/*
+* All three passes in place. The first positionComponents floats at positionOffset of every vertex are its position.
+*
+*   MeshOptimizerReport report = OptimizeMesh(vertices.data(), vertexCount, sizeof(Vertex), offsetof(Vertex, Position), 2,
+*       indices.data(), indexCount);
+*   VertexBuffer vb(vertices.data(), report.VertexCount * sizeof(Vertex));
+*   IndexBuffer ib(indices.data(), indexCount);
+*/
+MeshOptimizerReport OptimizeMesh(void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset, unsigned int positionComponents,
+	unsigned int* indices, size_t indexCount);
@@ -0,0 +1,150 @@
+#include "Meshlets.h"
+#include "Frustum.h"
+#include "IndirectCommandBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+static Vec3 Position(const float* positions, size_t positionStride, unsigned int positionComponents, unsigned int vertex)
+{
+    const float* p = (const float*)((const char*)positions + vertex * positionStride);
+    return { p[0], p[1], positionComponents > 2 ? p[2] : 0.0f };
+}
+
+Meshlets::Meshlets(const unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+    unsigned int positionComponents, unsigned int maxVertices, unsigned int maxTriangles)
+{
+    maxVertices = std::max(3u, std::min(maxVertices, 0xFFFFu));
+    maxTriangles = std::max(1u, std::min(maxTriangles, 0xFFFFu));
+
+    size_t triangleCount = indexCount / 3;
+
+    //stamp[v] is the meshlet number + 1 of the last meshlet that used vertex v.
+    std::vector<unsigned int> stamp(vertexCount, 0);
+    std::vector<unsigned int> vertices;     //of the meshlet being built
+    vertices.reserve(maxVertices);
+
+    size_t first = 0;
+    while (first < triangleCount) {
+        unsigned int id = (unsigned int)m_Meshlets.size() + 1;
+        vertices.clear();
+
+        //we take triangles while the vertices and the triangles fit.
+        size_t end = first;
+        while (end < triangleCount && end - first < maxTriangles) {
+            const unsigned int* triangle = indices + end * 3;
+
+            unsigned int added = 0;
+            for (unsigned int k = 0; k < 3; k++) {
+                bool duplicate = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+                added += stamp[triangle[k]] != id && !duplicate;
+            }
+            if (vertices.size() + added > maxVertices) {
+                break;
+            }
+
+            for (unsigned int k = 0; k < 3; k++) {
+                if (stamp[triangle[k]] != id) {
+                    stamp[triangle[k]] = id;
+                    vertices.push_back(triangle[k]);
+                }
+            }
+            end++;
+        }
+
+        Meshlet meshlet;
+        meshlet.FirstIndex = (unsigned int)(first * 3);
+        meshlet.TriangleCount = (unsigned short)(end - first);
+        meshlet.VertexCount = (unsigned short)vertices.size();
+
+        //the sphere around the middle of the bounding box.
+        Vec3 low = Position(positions, positionStride, positionComponents, vertices[0]);
+        Vec3 high = low;
+        for (unsigned int v : vertices) {
+            Vec3 p = Position(positions, positionStride, positionComponents, v);
+            low = { std::min(low.x, p.x), std::min(low.y, p.y), std::min(low.z, p.z) };
+            high = { std::max(high.x, p.x), std::max(high.y, p.y), std::max(high.z, p.z) };
+        }
+
+        meshlet.Center = (low + high) * 0.5f;
+        meshlet.Radius = 0.0f;
+        for (unsigned int v : vertices) {
+            meshlet.Radius = std::max(meshlet.Radius, Length(Position(positions, positionStride, positionComponents, v) - meshlet.Center));
+        }
+
+        //the cone: the average of the unit normals and how far the furthest one is from it.
+        Vec3 axis = { 0.0f, 0.0f, 0.0f };
+        for (size_t t = first; t < end; t++) {
+            Vec3 a = Position(positions, positionStride, positionComponents, indices[t * 3]);
+            Vec3 b = Position(positions, positionStride, positionComponents, indices[t * 3 + 1]);
+            Vec3 c = Position(positions, positionStride, positionComponents, indices[t * 3 + 2]);
+            axis = axis + Normalize(Cross(b - a, c - a));
+        }
+        axis = Normalize(axis);
+
+        float minDot = 1.0f;
+        for (size_t t = first; t < end; t++) {
+            Vec3 a = Position(positions, positionStride, positionComponents, indices[t * 3]);
+            Vec3 b = Position(positions, positionStride, positionComponents, indices[t * 3 + 1]);
+            Vec3 c = Position(positions, positionStride, positionComponents, indices[t * 3 + 2]);
+            Vec3 normal = Cross(b - a, c - a);
+
+            //degenerate triangles have no facing
+            if (Length(normal) > 0.0f) {
+                minDot = std::min(minDot, Dot(Normalize(normal), axis));
+            }
+        }
+
+        meshlet.ConeAxis = axis;
+        meshlet.ConeCutoff = minDot > 0.0f && Length(axis) > 0.0f ? std::sqrt(1.0f - minDot * minDot) : 1.0f;
+
+        m_Meshlets.push_back(meshlet);
+        first = end;
+    }
+}
+
+MeshletCullStats Meshlets::Cull(const Frustum& frustum, const Vec3& cameraPosition, IndirectCommandBuffer& commands) const
+{
+    MeshletCullStats stats = { 0, 0, 0, 0 };
+
+    //the current run of visible meshlets, they are next to each other in the index buffer.
+    unsigned int runFirst = 0;
+    unsigned int runCount = 0;
+
+    for (const Meshlet& meshlet : m_Meshlets) {
+        bool visible = false;
+
+        if (!frustum.IntersectsSphere(meshlet.Center, meshlet.Radius)) {
+            stats.OutsideFrustum++;
+        }
+        //every triangle faces away when the view direction is close enough to the cone axis, for any point of the sphere.
+        else if (Dot(meshlet.Center - cameraPosition, meshlet.ConeAxis) >= meshlet.ConeCutoff * Length(meshlet.Center - cameraPosition) + meshlet.Radius) {
+            stats.BackFacing++;
+        }
+        else {
+            visible = true;
+            stats.Visible++;
+        }
+
+        if (visible && runCount > 0 && runFirst + runCount == meshlet.FirstIndex) {
+            runCount += meshlet.TriangleCount * 3;
+            continue;
+        }
+
+        if (runCount > 0) {
+            commands.Add(runCount, runFirst);
+            stats.Commands++;
+            runCount = 0;
+        }
+        if (visible) {
+            runFirst = meshlet.FirstIndex;
+            runCount = meshlet.TriangleCount * 3;
+        }
+    }
+
+    if (runCount > 0) {
+        commands.Add(runCount, runFirst);
+        stats.Commands++;
+    }
+    return stats;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Math.h"
+
+#include <vector>
+#include <cstddef>
+
+struct Frustum;
+class IndirectCommandBuffer;
+
+/*
+* A run of at most MaxVertices vertices and MaxTriangles triangles of an index buffer, with what
+* the culling pass needs to skip it: a bounding sphere and the cone its triangle normals lie in.
+*/
+struct Meshlet
+{
+	Vec3 Center;			//bounding sphere
+	float Radius;
+	Vec3 ConeAxis;			//the average normal of its triangles
+	float ConeCutoff;		//sin of the cone's half angle, 1 when the triangles face too many ways to ever be back facing together
+	unsigned int FirstIndex;
+	unsigned short TriangleCount;
+	unsigned short VertexCount;
+};
+
+struct MeshletCullStats
+{
+	unsigned int Visible;
+	unsigned int OutsideFrustum;
+	unsigned int BackFacing;
+	unsigned int Commands;	//draws after merging neighbouring visible meshlets
+};
+
+/*
+* Cuts an index buffer into meshlets, in the order of its triangles, so every meshlet is a range of
+* the buffer that is drawn as it is. Run OptimizeVertexCache first (MeshOptimizer.h) so consecutive
+* triangles share vertices and the meshlets come out full and compact.
+*
+*   Meshlets meshlets(indices, indexCount, &vertices[0].Position.x, vertexCount, sizeof(Vertex), 3);
+*   commands.Clear();
+*   meshlets.Cull(Frustum::FromMatrix(viewProjection), cameraPosition, commands);
+*   renderer.DrawIndirect(va, ib, shader, commands);
+*
+* The frustum and the camera position must be in the space of the positions (model space).
+*/
+class Meshlets
+{
+public:
+	static const unsigned int MaxVertices = 64;
+	static const unsigned int MaxTriangles = 124;
+private:
+	std::vector<Meshlet> m_Meshlets;	//one contiguous array, the culling pass walks it front to back
+public:
+	//positions point to the first float of the position of vertex 0, positionStride is the size of a vertex in bytes
+	//and positionComponents is 2 or 3 (2D positions lie on z = 0).
+	Meshlets(const unsigned int* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+		unsigned int positionComponents, unsigned int maxVertices = MaxVertices, unsigned int maxTriangles = MaxTriangles);
+
+	//adds a draw command for every run of visible meshlets to commands.
+	MeshletCullStats Cull(const Frustum& frustum, const Vec3& cameraPosition, IndirectCommandBuffer& commands) const;
+
+	inline const std::vector<Meshlet>& GetMeshlets() const { return m_Meshlets; }
+	inline size_t GetCount() const { return m_Meshlets.size(); }
+};
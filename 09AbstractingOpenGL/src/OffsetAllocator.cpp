@@ -0,0 +1,317 @@
+#include "OffsetAllocator.h"
+#include "Renderer.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static const unsigned int MantissaBits = 3;
+static const unsigned int MantissaValue = 1 << MantissaBits;
+static const unsigned int MantissaMask = MantissaValue - 1;
+
+static unsigned int HighestBit(unsigned int value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, value);
+    return (unsigned int)index;
+#else
+    return 31 - (unsigned int)__builtin_clz(value);
+#endif
+}
+
+static unsigned int LowestBit(unsigned int value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctz(value);
+#endif
+}
+
+/*
+* Sizes go to bins like floats with a 3 bit mantissa: below 8 each size has its own bin, above that
+* each power of 2 is split in 8. Every range in a bin is at least as big as the bin's size.
+*/
+static unsigned int BinRoundDown(unsigned int size)
+{
+    if (size < MantissaValue) {
+        return size;
+    }
+
+    unsigned int shift = HighestBit(size) - MantissaBits;
+    return ((shift + 1) << MantissaBits) | ((size >> shift) & MantissaMask);
+}
+
+//the first bin where every range fits size.
+static unsigned int BinRoundUp(unsigned int size)
+{
+    if (size < MantissaValue) {
+        return size;
+    }
+
+    unsigned int shift = HighestBit(size) - MantissaBits;
+    unsigned int bin = ((shift + 1) << MantissaBits) | ((size >> shift) & MantissaMask);
+
+    //bits below the mantissa mean the bin's size is smaller, the next one is not. It carries into the exponent by itself.
+    if (size & ((1u << shift) - 1)) {
+        bin++;
+    }
+    return bin;
+}
+
+OffsetAllocator::OffsetAllocator(unsigned int capacity, unsigned int maxAllocations)
+    : m_Capacity(capacity)
+{
+    m_Nodes.reserve(maxAllocations);
+    Reset();
+}
+
+void OffsetAllocator::Reset()
+{
+    m_Nodes.clear();
+    m_FreeNodes.clear();
+    for (unsigned int& head : m_BinHeads) {
+        head = Unused;
+    }
+    m_UsedTopBins = 0;
+    for (unsigned char& bins : m_UsedBins) {
+        bins = 0;
+    }
+    m_FreeStorage = 0;
+    m_FreeRegions = 0;
+    m_Allocations = 0;
+
+    if (m_Capacity) {
+        InsertFree(NewNode(0, m_Capacity, false));
+    }
+}
+
+unsigned int OffsetAllocator::NewNode(unsigned int offset, unsigned int size, bool used)
+{
+    unsigned int node;
+    if (!m_FreeNodes.empty()) {
+        node = m_FreeNodes.back();
+        m_FreeNodes.pop_back();
+    }
+    else {
+        node = (unsigned int)m_Nodes.size();
+        m_Nodes.push_back({});
+    }
+
+    m_Nodes[node] = { offset, size, Unused, Unused, Unused, Unused, used };
+    return node;
+}
+
+void OffsetAllocator::InsertFree(unsigned int node)
+{
+    unsigned int bin = BinRoundDown(m_Nodes[node].size);
+
+    //it goes first in its bin.
+    m_Nodes[node].binPrevious = Unused;
+    m_Nodes[node].binNext = m_BinHeads[bin];
+    if (m_BinHeads[bin] != Unused) {
+        m_Nodes[m_BinHeads[bin]].binPrevious = node;
+    }
+    m_BinHeads[bin] = node;
+
+    m_UsedBins[bin >> MantissaBits] |= 1 << (bin & MantissaMask);
+    m_UsedTopBins |= 1u << (bin >> MantissaBits);
+
+    m_FreeStorage += m_Nodes[node].size;
+    m_FreeRegions++;
+}
+
+void OffsetAllocator::RemoveFree(unsigned int node)
+{
+    Node& removed = m_Nodes[node];
+    if (removed.binPrevious != Unused) {
+        m_Nodes[removed.binPrevious].binNext = removed.binNext;
+    }
+    else {
+        //it was the head, the bin may be empty now.
+        unsigned int bin = BinRoundDown(removed.size);
+        m_BinHeads[bin] = removed.binNext;
+        if (removed.binNext == Unused) {
+            m_UsedBins[bin >> MantissaBits] &= ~(1 << (bin & MantissaMask));
+            if (!m_UsedBins[bin >> MantissaBits]) {
+                m_UsedTopBins &= ~(1u << (bin >> MantissaBits));
+            }
+        }
+    }
+    if (removed.binNext != Unused) {
+        m_Nodes[removed.binNext].binPrevious = removed.binPrevious;
+    }
+
+    m_FreeStorage -= removed.size;
+    m_FreeRegions--;
+}
+
+unsigned int OffsetAllocator::FindFreeBin(unsigned int minimumBin) const
+{
+    if (minimumBin >= BinCount) {
+        return Unused;
+    }
+
+    //the bins left in the same power of 2...
+    unsigned int top = minimumBin >> MantissaBits;
+    unsigned int bins = m_UsedBins[top] & (0xFFu << (minimumBin & MantissaMask)) & 0xFF;
+    if (bins) {
+        return (top << MantissaBits) | LowestBit(bins);
+    }
+
+    //...or the smallest bin of the next power of 2 that has any.
+    unsigned int tops = top + 1 < 32 ? m_UsedTopBins & (0xFFFFFFFFu << (top + 1)) : 0;
+    if (!tops) {
+        return Unused;
+    }
+    top = LowestBit(tops);
+    return (top << MantissaBits) | LowestBit(m_UsedBins[top]);
+}
+
+unsigned int OffsetAllocator::Allocate(unsigned int size)
+{
+    if (size == 0 || size > m_Capacity) {
+        return NoSpace;
+    }
+
+    unsigned int bin = FindFreeBin(BinRoundUp(size));
+    if (bin == Unused) {
+        return NoSpace;
+    }
+
+    unsigned int node = m_BinHeads[bin];
+    RemoveFree(node);
+
+    //what's left after the allocation stays free, right after it.
+    unsigned int remainder = m_Nodes[node].size - size;
+    m_Nodes[node].size = size;
+    m_Nodes[node].used = true;
+    if (remainder > 0) {
+        unsigned int rest = NewNode(m_Nodes[node].offset + size, remainder, false);
+        m_Nodes[rest].neighborPrevious = node;
+        m_Nodes[rest].neighborNext = m_Nodes[node].neighborNext;
+        if (m_Nodes[node].neighborNext != Unused) {
+            m_Nodes[m_Nodes[node].neighborNext].neighborPrevious = rest;
+        }
+        m_Nodes[node].neighborNext = rest;
+        InsertFree(rest);
+    }
+
+    m_Allocations++;
+    return node;
+}
+
+void OffsetAllocator::Free(unsigned int allocation)
+{
+    ASSERT(allocation < m_Nodes.size() && m_Nodes[allocation].used);
+
+    Node& node = m_Nodes[allocation];
+    node.used = false;
+    m_Allocations--;
+
+    //we swallow the free neighbours on both sides.
+    unsigned int previous = node.neighborPrevious;
+    if (previous != Unused && !m_Nodes[previous].used) {
+        RemoveFree(previous);
+        node.offset = m_Nodes[previous].offset;
+        node.size += m_Nodes[previous].size;
+        node.neighborPrevious = m_Nodes[previous].neighborPrevious;
+        if (node.neighborPrevious != Unused) {
+            m_Nodes[node.neighborPrevious].neighborNext = allocation;
+        }
+        m_FreeNodes.push_back(previous);
+    }
+
+    unsigned int next = node.neighborNext;
+    if (next != Unused && !m_Nodes[next].used) {
+        RemoveFree(next);
+        node.size += m_Nodes[next].size;
+        node.neighborNext = m_Nodes[next].neighborNext;
+        if (node.neighborNext != Unused) {
+            m_Nodes[node.neighborNext].neighborPrevious = allocation;
+        }
+        m_FreeNodes.push_back(next);
+    }
+
+    InsertFree(allocation);
+}
+
+OffsetAllocator::Stats OffsetAllocator::GetStats() const
+{
+    Stats stats;
+    stats.Free = m_FreeStorage;
+    stats.Used = m_Capacity - m_FreeStorage;
+    stats.FreeRegions = m_FreeRegions;
+    stats.Allocations = m_Allocations;
+
+    //the largest range is in the highest bin that has any, but not necessarily first.
+    stats.LargestFree = 0;
+    if (m_UsedTopBins) {
+        unsigned int top = HighestBit(m_UsedTopBins);
+        unsigned int bin = (top << MantissaBits) | HighestBit(m_UsedBins[top]);
+        for (unsigned int node = m_BinHeads[bin]; node != Unused; node = m_Nodes[node].binNext) {
+            stats.LargestFree = std::max(stats.LargestFree, m_Nodes[node].size);
+        }
+    }
+
+    stats.Fragmentation = stats.Free ? 1.0f - (float)stats.LargestFree / stats.Free : 0.0f;
+    return stats;
+}
+
+void OffsetAllocator::Compact(const std::function<void(unsigned int from, unsigned int to, unsigned int size)>& move)
+{
+    std::vector<unsigned int> allocations;
+    for (unsigned int node = 0; node < m_Nodes.size(); node++) {
+        if (m_Nodes[node].used) {
+            allocations.push_back(node);
+        }
+    }
+    std::sort(allocations.begin(), allocations.end(),
+        [&](unsigned int a, unsigned int b) { return m_Nodes[a].offset < m_Nodes[b].offset; });
+
+    unsigned int end = 0;
+    for (unsigned int node : allocations) {
+        if (m_Nodes[node].offset != end) {
+            move(m_Nodes[node].offset, end, m_Nodes[node].size);
+            m_Nodes[node].offset = end;
+        }
+        end += m_Nodes[node].size;
+    }
+
+    //the free ranges are gone, and the ids of the free nodes with them. The allocations keep theirs.
+    for (unsigned int& head : m_BinHeads) {
+        head = Unused;
+    }
+    m_UsedTopBins = 0;
+    for (unsigned char& bins : m_UsedBins) {
+        bins = 0;
+    }
+    m_FreeStorage = 0;
+    m_FreeRegions = 0;
+    m_FreeNodes.clear();
+    for (unsigned int node = 0; node < m_Nodes.size(); node++) {
+        if (!m_Nodes[node].used) {
+            m_FreeNodes.push_back(node);
+        }
+    }
+
+    for (size_t i = 0; i < allocations.size(); i++) {
+        Node& node = m_Nodes[allocations[i]];
+        node.neighborPrevious = i > 0 ? allocations[i - 1] : Unused;
+        node.neighborNext = i + 1 < allocations.size() ? allocations[i + 1] : Unused;
+    }
+
+    if (end < m_Capacity) {
+        unsigned int rest = NewNode(end, m_Capacity - end, false);
+        if (!allocations.empty()) {
+            m_Nodes[rest].neighborPrevious = allocations.back();
+            m_Nodes[allocations.back()].neighborNext = rest;
+        }
+        InsertFree(rest);
+    }
+}
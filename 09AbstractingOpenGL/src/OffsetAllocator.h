@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+
+/*
+* Hands out ranges of [0, capacity) in constant time, for memory the CPU can't touch like the inside of
+* a GL buffer. It's a TLSF (two level segregated fit): free ranges are kept in bins by size, 8 bins per
+* power of 2, and two levels of bitmasks find the first bin with a range big enough without looking at
+* the others. Freed ranges merge with their free neighbours right away.
+*
+* Units are whatever the caller wants, BufferPool uses vertices or indices.
+*/
+class OffsetAllocator
+{
+public:
+	static const unsigned int NoSpace = 0xFFFFFFFF;
+
+	struct Stats
+	{
+		unsigned int Used;
+		unsigned int Free;
+		unsigned int LargestFree;	//the biggest Allocate that would succeed now
+		unsigned int FreeRegions;
+		unsigned int Allocations;
+		float Fragmentation;		//1 - LargestFree / Free: 0 when all the free space is one range
+	};
+private:
+	static const unsigned int BinCount = 256;	//5 bits of exponent and 3 of mantissa
+	static const unsigned int Unused = 0xFFFFFFFF;
+
+	struct Node
+	{
+		unsigned int offset;
+		unsigned int size;
+		unsigned int binPrevious;	//free ranges of the same bin
+		unsigned int binNext;
+		unsigned int neighborPrevious;	//the ranges right before and after this one
+		unsigned int neighborNext;
+		bool used;
+	};
+
+	unsigned int m_Capacity;
+	std::vector<Node> m_Nodes;
+	std::vector<unsigned int> m_FreeNodes;	//stack of unused entries of m_Nodes
+	unsigned int m_BinHeads[BinCount];
+	unsigned int m_UsedTopBins;			//bit e: some bin with exponent e has a free range
+	unsigned char m_UsedBins[BinCount / 8];	//bit m of byte e: bin (e, m) has a free range
+	unsigned int m_FreeStorage;
+	unsigned int m_FreeRegions;
+	unsigned int m_Allocations;
+
+	unsigned int NewNode(unsigned int offset, unsigned int size, bool used);
+	void InsertFree(unsigned int node);
+	void RemoveFree(unsigned int node);
+	unsigned int FindFreeBin(unsigned int minimumBin) const;
+	void Reset();
+public:
+	//maxAllocations bounds the live allocations plus the free ranges between them.
+	OffsetAllocator(unsigned int capacity, unsigned int maxAllocations = 65536);
+
+	//returns the allocation (an id to give to the other calls) or NoSpace.
+	unsigned int Allocate(unsigned int size);
+	void Free(unsigned int allocation);
+
+	inline unsigned int GetOffset(unsigned int allocation) const { return m_Nodes[allocation].offset; }
+	inline unsigned int GetSize(unsigned int allocation) const { return m_Nodes[allocation].size; }
+	inline unsigned int GetCapacity() const { return m_Capacity; }
+
+	Stats GetStats() const;
+
+	/*
+	* Slides every allocation down so the free space becomes one range at the end. The ids stay the same,
+	* the offsets don't. move(from, to, size) is called for each allocation that moves, lowest first, so
+	* the caller can move its data; to is always below from.
+	*/
+	void Compact(const std::function<void(unsigned int from, unsigned int to, unsigned int size)>& move);
+};
@@ -0,0 +1,226 @@
+#include "ProgramCache.h"
+#include "Shader.h"
+#include "Renderer.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+//the start of every cache file
+struct ProgramBinaryHeader
+{
+    char magic[4];              //"TCNP"
+    unsigned int version;       //of this layout
+    unsigned long long key;     //the same as the file name, in case the file got renamed
+    unsigned int format;        //what glGetProgramBinary said
+    unsigned int length;        //bytes of binary after the header
+};
+
+static const unsigned int ProgramBinaryVersion = 1;
+
+static std::string s_Directory;
+static int s_Supported = -1;    //-1 not asked yet
+static ProgramCache::Stats s_Stats = { 0, 0, 0, 0 };
+
+static unsigned long long Hash(unsigned long long hash, const char* data, size_t length)
+{
+    //FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+//an extra round after every string, so "ab" + "c" and "a" + "bc" differ.
+static unsigned long long EndString(unsigned long long hash)
+{
+    return hash * 1099511628211ull;
+}
+
+static std::string FilePath(unsigned long long key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", key);
+    return s_Directory + "/" + name;
+}
+
+//the driver can load binaries in this format.
+static bool IsFormatSupported(unsigned int format)
+{
+    int count = 0;
+    GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count));
+
+    std::vector<int> formats(count);
+    if (count > 0) {
+        GLCall(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data()));
+    }
+
+    for (int supported : formats) {
+        if ((unsigned int)supported == format) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProgramCache::SetDirectory(const std::string& directory)
+{
+    s_Directory = directory;
+}
+
+const std::string& ProgramCache::GetDirectory()
+{
+    return s_Directory;
+}
+
+bool ProgramCache::IsEnabled()
+{
+    if (s_Directory.empty()) {
+        return false;
+    }
+
+    if (s_Supported < 0) {
+        int count = 0;
+        if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+            GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count));
+        }
+        s_Supported = count > 0;
+    }
+    return s_Supported != 0;
+}
+
+unsigned long long ProgramCache::Key(const ShaderProgramSource& source)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    //the text of every stage, however the parser cut it in pieces.
+    for (const std::vector<std::string_view>& stage : source.Stages) {
+        for (std::string_view piece : stage) {
+            hash = Hash(hash, piece.data(), piece.size());
+        }
+        hash = EndString(hash);
+    }
+
+    //the binaries are only good for the driver that made them.
+    const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+    for (GLenum name : strings) {
+        const char* value = GLCallValue((const char*)glGetString(name));
+        hash = EndString(Hash(hash, value ? value : "", value ? strlen(value) : 0));
+    }
+    return hash;
+}
+
+unsigned int ProgramCache::Load(unsigned long long key)
+{
+    if (!IsEnabled()) {
+        return 0;
+    }
+
+    std::string path = FilePath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        s_Stats.misses++;
+        return 0;
+    }
+
+    ProgramBinaryHeader header;
+    std::vector<char> binary;
+    bool valid = file.read((char*)&header, sizeof(header))
+        && memcmp(header.magic, "TCNP", 4) == 0
+        && header.version == ProgramBinaryVersion
+        && header.key == key
+        && IsFormatSupported(header.format);
+
+    //the length has to be what is left of the file, a corrupt one mustn't make us allocate gigabytes.
+    if (valid) {
+        std::error_code error;
+        unsigned long long fileSize = std::filesystem::file_size(path, error);
+        valid = !error && fileSize == sizeof(header) + (unsigned long long)header.length;
+    }
+
+    if (valid) {
+        binary.resize(header.length);
+        valid = (bool)file.read(binary.data(), header.length);
+    }
+    file.close();
+
+    unsigned int program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        GLCall(glProgramBinary(program, header.format, binary.data(), header.length));
+
+        int linked = GL_FALSE;
+        GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+        if (linked == GL_FALSE) {
+            GLCall(glDeleteProgram(program));
+            program = 0;
+        }
+    }
+
+    if (!program) {
+        std::cout << "Discarding program binary " << path << std::endl;
+        std::remove(path.c_str());
+        s_Stats.rejected++;
+        return 0;
+    }
+
+    s_Stats.hits++;
+    return program;
+}
+
+void ProgramCache::Store(unsigned long long key, unsigned int program)
+{
+    if (!IsEnabled() || program == 0) {
+        return;
+    }
+
+    int linked = GL_FALSE;
+    int length = 0;
+    GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (linked == GL_FALSE || length <= 0) {
+        return;
+    }
+
+    ProgramBinaryHeader header = { { 'T', 'C', 'N', 'P' }, ProgramBinaryVersion, key, 0, 0 };
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLCall(glGetProgramBinary(program, length, &length, &format, binary.data()));
+    header.format = format;
+    header.length = (unsigned int)length;
+
+    std::error_code error;
+    std::filesystem::create_directories(s_Directory, error);
+
+    //we write next to it and rename, so another instance never reads half a file.
+    std::string path = FilePath(key);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write((const char*)&header, sizeof(header)) || !file.write(binary.data(), length)) {
+            std::cout << "Couldn't write the program binary " << temporary << std::endl;
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::cout << "Couldn't store the program binary " << path << ": " << error.message() << std::endl;
+        std::remove(temporary.c_str());
+        return;
+    }
+    s_Stats.stored++;
+}
+
+ProgramCache::Stats ProgramCache::GetStats()
+{
+    return s_Stats;
+}
+
+void ProgramCache::ResetStats()
+{
+    s_Stats = { 0, 0, 0, 0 };
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+
+struct ShaderProgramSource;
+
+/*
+* Keeps linked programs on disk as glGetProgramBinary blobs, one file per program named after a
+* hash of its sources and of the driver's vendor, renderer and version strings. A new driver or an
+* edited shader gives a new name, so stale files are simply never read again. When the driver
+* rejects a blob anyway the file is deleted and the caller compiles the program from source.
+*
+*   unsigned long long key = ProgramCache::Key(source);
+*   unsigned int program = ProgramCache::Load(key);
+*   if (!program) {
+*       program = ...compile and link...
+*       ProgramCache::Store(key, program);
+*   }
+*/
+class ProgramCache
+{
+public:
+	struct Stats
+	{
+		unsigned int hits;		//programs loaded from a binary
+		unsigned int misses;	//no file for the key
+		unsigned int rejected;	//files the driver didn't take (or that were broken)
+		unsigned int stored;
+	};
+
+	//"" turns the cache off. The directory is created on the first Store.
+	static void SetDirectory(const std::string& directory);
+	static const std::string& GetDirectory();
+
+	//there is a directory and the driver has at least one binary format.
+	static bool IsEnabled();
+
+	static unsigned long long Key(const ShaderProgramSource& source);
+
+	//a linked program, or 0 if the cache is off or has nothing usable for the key.
+	static unsigned int Load(unsigned long long key);
+	//the program must be linked and should have GL_PROGRAM_BINARY_RETRIEVABLE_HINT set before linking.
+	static void Store(unsigned long long key, unsigned int program);
+
+	static Stats GetStats();
+	static void ResetStats();
+};
@@ -1,6 +1,14 @@
 #include "Renderer.h"
+#include "GLState.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "IndirectCommandBuffer.h"
 
 #include <iostream>
+#include <vector>
+#include <algorithm>
 
 void GLClearError()
 {
@@ -17,4 +25,233 @@ bool GLLogCall(const char* function, const char* file, int line)
         return false;
     }
     return true;
-}
\ No newline at end of file
+}
+
+const char* GLCallModeName()
+{
+#if GLCALL_MODE == GLCALL_MODE_RELEASE
+    return "release";
+#elif GLCALL_MODE == GLCALL_MODE_DEBUG_OUTPUT
+    return "debug-output";
+#else
+    return "glGetError";
+#endif
+}
+
+#if GLCALL_MODE == GLCALL_MODE_DEBUG_OUTPUT
+
+thread_local GLCallSite g_GLCallSite = { nullptr, nullptr, 0 };
+
+static void GLAPIENTRY GLDebugMessageCallback(GLenum /*source*/, GLenum type, GLuint id, GLenum severity,
+    GLsizei /*length*/, const GLchar* message, const void* /*userParam*/)
+{
+    //notifications are things like "buffer will use video memory", they are just noise.
+    if (severity == GL_DEBUG_SEVERITY_NOTIFICATION) {
+        return;
+    }
+
+    std::cout << "[OpenGL " << (type == GL_DEBUG_TYPE_ERROR ? "Error" : "Debug") << "] (" << id << "): "
+        << message;
+
+    const GLCallSite& site = g_GLCallSite;
+    if (site.function) {
+        std::cout << " "
+            << site.function << " "
+            << site.file << ":"
+            << site.line;
+    }
+    std::cout << std::endl;
+
+    if (type == GL_DEBUG_TYPE_ERROR) {
+        DEBUG_BREAK();
+    }
+}
+
+bool GLInitDebugOutput()
+{
+    if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug) {
+        std::cout << "GL_KHR_debug is not available, GL errors won't be reported." << std::endl;
+        return false;
+    }
+
+    GLCall(glEnable(GL_DEBUG_OUTPUT));
+    //synchronous so the callback runs inside the GL call and the call site tag is still valid.
+    GLCall(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    GLCall(glDebugMessageCallback(GLDebugMessageCallback, nullptr));
+    GLCall(glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE));
+    return true;
+}
+
+#else
+
+bool GLInitDebugOutput()
+{
+    return true;
+}
+
+#endif
+
+#ifdef GLCALL_PROFILE
+
+//the head of the list of counters. They are pushed once, when each call site runs for the first time.
+static std::atomic<GLCallCounter*> s_GLCallCounters(nullptr);
+
+GLCallCounter::GLCallCounter(const char* function, const char* file, int line)
+    : function(function), file(file), line(line), count(0), nanoseconds(0), next(nullptr)
+{
+    next = s_GLCallCounters.load(std::memory_order_relaxed);
+    while (!s_GLCallCounters.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+#endif
+
+//quotes a string for CSV or JSON.
+static void GLCallProfileWriteString(std::ostream& stream, const char* text, GLCallProfileFormat format)
+{
+    stream << '"';
+    for (const char* c = text; *c; c++) {
+        if (*c == '"') {
+            stream << (format == GLCallProfileFormat::CSV ? "\"\"" : "\\\"");
+        }
+        else if (*c == '\\' && format == GLCallProfileFormat::JSON) {
+            stream << "\\\\";
+        }
+        else if (*c == '\n' || *c == '\r' || *c == '\t') {
+            stream << ' ';
+        }
+        else {
+            stream << *c;
+        }
+    }
+    stream << '"';
+}
+
+void GLCallProfileDump(std::ostream& stream, GLCallProfileFormat format)
+{
+    struct Row
+    {
+        const char* function;
+        const char* file;
+        int line;
+        unsigned long long count;
+        unsigned long long nanoseconds;
+    };
+
+    std::vector<Row> rows;
+#ifdef GLCALL_PROFILE
+    for (GLCallCounter* counter = s_GLCallCounters.load(std::memory_order_acquire); counter; counter = counter->next) {
+        rows.push_back({
+            counter->function,
+            counter->file,
+            counter->line,
+            counter->count.load(std::memory_order_relaxed),
+            counter->nanoseconds.load(std::memory_order_relaxed)
+        });
+    }
+
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.nanoseconds > b.nanoseconds; });
+#endif
+
+    if (format == GLCallProfileFormat::CSV) {
+        stream << "file,line,call,count,total_ns,avg_ns\n";
+        for (const Row& row : rows) {
+            GLCallProfileWriteString(stream, row.file, format);
+            stream << ',' << row.line << ',';
+            GLCallProfileWriteString(stream, row.function, format);
+            stream << ',' << row.count << ',' << row.nanoseconds << ','
+                << (row.count ? row.nanoseconds / row.count : 0) << '\n';
+        }
+    }
+    else {
+        stream << "[\n";
+        for (size_t i = 0; i < rows.size(); i++) {
+            const Row& row = rows[i];
+            stream << "  { \"file\": ";
+            GLCallProfileWriteString(stream, row.file, format);
+            stream << ", \"line\": " << row.line << ", \"call\": ";
+            GLCallProfileWriteString(stream, row.function, format);
+            stream << ", \"count\": " << row.count
+                << ", \"total_ns\": " << row.nanoseconds
+                << ", \"avg_ns\": " << (row.count ? row.nanoseconds / row.count : 0)
+                << " }" << (i + 1 < rows.size() ? "," : "") << '\n';
+        }
+        stream << "]\n";
+    }
+    stream.flush();
+}
+
+void GLCallProfileReset()
+{
+#ifdef GLCALL_PROFILE
+    for (GLCallCounter* counter = s_GLCallCounters.load(std::memory_order_acquire); counter; counter = counter->next) {
+        counter->count.store(0, std::memory_order_relaxed);
+        counter->nanoseconds.store(0, std::memory_order_relaxed);
+    }
+#endif
+}
+
+void Renderer::Clear() const
+{
+    GLCall(glClear(GL_COLOR_BUFFER_BIT));
+}
+
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
+{
+#if GLCALL_MODE != GLCALL_MODE_RELEASE
+    shader.CheckVertexArray(va);
+#endif
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+
+    GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), ib.GetType(), (const void*)(size_t)ib.GetOffset()));
+}
+
+void Renderer::Draw(const VertexArray& va, const VertexBuffer& vb, const IndexBuffer& ib, const Shader& shader) const
+{
+#if GLCALL_MODE != GLCALL_MODE_RELEASE
+    shader.CheckVertexArray(va);
+#endif
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+
+    //the indices of the mesh start at 0, the base vertex moves them to where its vertices are in the pool.
+    GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, ib.GetCount(), ib.GetType(), (const void*)(size_t)ib.GetOffset(),
+        (int)vb.GetBaseVertex()));
+}
+
+void Renderer::DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int count) const
+{
+#if GLCALL_MODE != GLCALL_MODE_RELEASE
+    shader.CheckVertexArray(va);
+#endif
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+
+    GLCall(glDrawElementsInstanced(GL_TRIANGLES, ib.GetCount(), ib.GetType(), (const void*)(size_t)ib.GetOffset(), count));
+}
+
+void Renderer::DrawIndirect(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, IndirectCommandBuffer& commands) const
+{
+#if GLCALL_MODE != GLCALL_MODE_RELEASE
+    shader.CheckVertexArray(va);
+#endif
+    if (commands.GetCount() == 0) {
+        return;
+    }
+
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+    commands.Bind();
+
+    GLCall(glMultiDrawElementsIndirect(
+        GL_TRIANGLES,
+        ib.GetType(),
+        nullptr,                //the commands start at the beginning of the indirect buffer
+        commands.GetCount(),
+        0                       //they are tightly packed
+    ));
+}
@@ -1,10 +1,189 @@
 #pragma once
 #include <GL/glew.h>
 
-#define ASSERT(x) if(!(x)) __debugbreak();
-#define GLCall(x) GLClearError();\
-    x;\
-    ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+#include <iosfwd>
+
+#ifdef _MSC_VER
+#define DEBUG_BREAK() __debugbreak()
+#else
+#include <csignal>
+#define DEBUG_BREAK() raise(SIGTRAP)
+#endif
+
+#define ASSERT(x) if(!(x)) DEBUG_BREAK();
+
+/*
+* How GLCall checks for errors. It is chosen at build time with -DGLCALL_MODE=...
+*   GLCALL_MODE_RELEASE       GLCall(x) is just x. The default when NDEBUG is defined.
+*   GLCALL_MODE_GETERROR      clears and polls glGetError around every call. The default otherwise.
+*   GLCALL_MODE_DEBUG_OUTPUT  the driver reports errors through a KHR_debug callback (see GLInitDebugOutput)
+*                             and GLCall only tags the current thread with the call site.
+*/
+#define GLCALL_MODE_RELEASE 0
+#define GLCALL_MODE_GETERROR 1
+#define GLCALL_MODE_DEBUG_OUTPUT 2
+
+#ifndef GLCALL_MODE
+#ifdef NDEBUG
+#define GLCALL_MODE GLCALL_MODE_RELEASE
+#else
+#define GLCALL_MODE GLCALL_MODE_GETERROR
+#endif
+#endif
+
+/*
+* GLCall(x) is one statement, so it can go anywhere a statement can: under an if without braces, after a case
+* label, twice on a line. Calls whose value we keep use GLCallValue, an expression:
+*
+*   GLCall(glBindBuffer(GL_ARRAY_BUFFER, id));
+*   int location = GLCallValue(glGetUniformLocation(program, "u_Color"));
+*/
+#if GLCALL_MODE == GLCALL_MODE_RELEASE
+
+#define GLCallChecked(x) do { x; } while (0)
+#define GLCallValueChecked(x) (x)
+
+#elif GLCALL_MODE == GLCALL_MODE_DEBUG_OUTPUT
+
+struct GLCallSite
+{
+    const char* function;
+    const char* file;
+    int line;
+};
+
+//the call being executed by this thread, so the debug callback knows where a message comes from.
+extern thread_local GLCallSite g_GLCallSite;
+
+#define GLCallChecked(x) do {\
+        g_GLCallSite = { #x, __FILE__, __LINE__ };\
+        x;\
+        g_GLCallSite.function = nullptr;\
+    } while (0)
+
+#define GLCallValueChecked(x) [&]() {\
+        g_GLCallSite = { #x, __FILE__, __LINE__ };\
+        auto glCallResult = x;\
+        g_GLCallSite.function = nullptr;\
+        return glCallResult;\
+    }()
+
+#else
+
+#define GLCallChecked(x) do {\
+        GLClearError();\
+        x;\
+        ASSERT(GLLogCall(#x, __FILE__, __LINE__));\
+    } while (0)
+
+#define GLCallValueChecked(x) [&]() {\
+        GLClearError();\
+        auto glCallResult = x;\
+        ASSERT(GLLogCall(#x, __FILE__, __LINE__));\
+        return glCallResult;\
+    }()
+
+#endif
+
+/*
+* With -DGLCALL_PROFILE every GLCall site gets a counter with the number of calls and the CPU time spent in them,
+* keyed by file, line and the text of the call. Without it GLCall is exactly GLCallChecked.
+*/
+#ifdef GLCALL_PROFILE
+
+#include <atomic>
+#include <chrono>
+
+struct GLCallCounter
+{
+    const char* function;
+    const char* file;
+    int line;
+    std::atomic<unsigned long long> count;
+    std::atomic<unsigned long long> nanoseconds;
+    GLCallCounter* next; //all the counters make a list that only grows, see GLCallProfileDump
+
+    GLCallCounter(const char* function, const char* file, int line);
+
+    inline void Record(std::chrono::steady_clock::duration elapsed)
+    {
+        count.fetch_add(1, std::memory_order_relaxed);
+        nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+    }
+};
+
+//times its scope into a counter.
+struct GLCallTimer
+{
+    GLCallCounter& counter;
+    std::chrono::steady_clock::time_point start;
+
+    inline GLCallTimer(GLCallCounter& counter) : counter(counter), start(std::chrono::steady_clock::now()) {}
+    inline ~GLCallTimer() { counter.Record(std::chrono::steady_clock::now() - start); }
+};
+
+//the counter is a static of the block (or the lambda), so every site has its own and the names never collide.
+#define GLCall(x) do {\
+        static GLCallCounter glCallCounter(#x, __FILE__, __LINE__);\
+        GLCallTimer glCallTimer(glCallCounter);\
+        GLCallChecked(x);\
+    } while (0)
+
+#define GLCallValue(x) [&]() {\
+        static GLCallCounter glCallCounter(#x, __FILE__, __LINE__);\
+        GLCallTimer glCallTimer(glCallCounter);\
+        return GLCallValueChecked(x);\
+    }()
+
+#else
+
+#define GLCall(x) GLCallChecked(x)
+#define GLCallValue(x) GLCallValueChecked(x)
+
+#endif
+
+enum class GLCallProfileFormat
+{
+    CSV,
+    JSON
+};
+
+//writes every GLCall site that has run, the most expensive first. It's empty unless built with GLCALL_PROFILE.
+void GLCallProfileDump(std::ostream& stream, GLCallProfileFormat format);
+
+//sets all the counters back to zero.
+void GLCallProfileReset();
+
+//name of the GLCall mode this was built with.
+const char* GLCallModeName();
+
+//in GLCALL_MODE_DEBUG_OUTPUT it installs the debug callback; it must be called once the context is current.
+//in the other modes it does nothing. It returns false if the context can't report debug output.
+bool GLInitDebugOutput();
 
 void GLClearError();
-bool GLLogCall(const char* function, const char* file, int line);
\ No newline at end of file
+bool GLLogCall(const char* function, const char* file, int line);
+
+class VertexArray;
+class VertexBuffer;
+class IndexBuffer;
+class Shader;
+class IndirectCommandBuffer;
+
+class Renderer
+{
+public:
+	void Clear() const;
+
+	void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+
+	//for meshes in BufferPools: va reads the whole vertex pool and vb says where this mesh starts in it.
+	void Draw(const VertexArray& va, const VertexBuffer& vb, const IndexBuffer& ib, const Shader& shader) const;
+
+	//draws count copies of the mesh in a single call. The vertex array should have per-instance attributes (a buffer added with a divisor).
+	void DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int count) const;
+
+	//every command of the buffer with one glMultiDrawElementsIndirect. They index into ib and the buffers of va.
+	//with BufferPools the commands take FirstIndex and BaseVertex from the IndexBuffer and VertexBuffer of each mesh.
+	void DrawIndirect(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, IndirectCommandBuffer& commands) const;
+};
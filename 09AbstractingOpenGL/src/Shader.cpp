@@ -0,0 +1,690 @@
+#include "Shader.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "ProgramCache.h"
+#include "MappedFile.h"
+#include "VertexArray.h"
+
+#include <iostream>
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#else
+#include <alloca.h>
+#endif
+
+static const char* const StageNames[(int)ShaderStage::Count] = { "vertex", "tesscontrol", "tesseval", "geometry", "fragment", "compute" };
+static const unsigned int StageTypes[(int)ShaderStage::Count] = {
+    GL_VERTEX_SHADER, GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER, GL_COMPUTE_SHADER
+};
+
+//a mapped file and what it looked like on disk when we mapped it.
+struct CachedShaderFile
+{
+    std::shared_ptr<const MappedFile> file;
+    std::filesystem::file_time_type time;
+    uintmax_t size;
+};
+
+//every file ParseShader has read, so the ones included by many shaders are mapped once.
+//ShaderWatcher parses on its own thread, hence the mutex.
+static std::unordered_map<std::string, CachedShaderFile> s_ShaderFiles;
+static std::mutex s_ShaderFilesMutex;
+
+static std::shared_ptr<const MappedFile> OpenShaderFile(const std::string& path, MappedFile::Access access)
+{
+    //a copy is only good for the parse that asked for it, and a mapping from the cache could change under it.
+    if (access == MappedFile::Access::Read) {
+        std::shared_ptr<const MappedFile> file = std::make_shared<const MappedFile>(path, access);
+        return file->IsOpen() ? file : nullptr;
+    }
+
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    uintmax_t size = error ? 0 : std::filesystem::file_size(path, error);
+    if (error) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(s_ShaderFilesMutex);
+    auto it = s_ShaderFiles.find(path);
+    if (it != s_ShaderFiles.end() && it->second.time == time && it->second.size == size) {
+        return it->second.file;
+    }
+
+    //new or changed, the shaders still using the old mapping keep it alive.
+    std::shared_ptr<const MappedFile> file = std::make_shared<const MappedFile>(path);
+    if (!file->IsOpen()) {
+        return nullptr;
+    }
+    s_ShaderFiles[path] = { file, time, size };
+    return file;
+}
+
+static std::string_view TrimLeft(std::string_view text)
+{
+    size_t start = text.find_first_not_of(" \t");
+    return start == std::string_view::npos ? std::string_view() : text.substr(start);
+}
+
+static std::string_view Trim(std::string_view text)
+{
+    text = TrimLeft(text);
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return end == std::string_view::npos ? std::string_view() : text.substr(0, end + 1);
+}
+
+static bool StartsWith(std::string_view text, std::string_view prefix)
+{
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+//-1 if it isn't a stage we know
+static int StageFromName(std::string_view name)
+{
+    for (int stage = 0; stage < (int)ShaderStage::Count; stage++) {
+        if (name == StageNames[stage]) {
+            return stage;
+        }
+    }
+    return -1;
+}
+
+/*
+* Walks one file line by line. Plain lines aren't looked at beyond their first characters: runs of
+* them become one piece of the current stage, and only the directives cut a run.
+*/
+class ShaderParser
+{
+private:
+    ShaderProgramSource& m_Source;
+    MappedFile::Access m_Access;
+    int m_Stage;
+    std::unordered_set<std::string> m_Included[(int)ShaderStage::Count + 1]; //per stage, the last one before any #shader
+public:
+    ShaderParser(ShaderProgramSource& source, MappedFile::Access access)
+        : m_Source(source), m_Access(access), m_Stage(-1)
+    {
+    }
+
+    bool ParseFile(const std::string& path, int depth)
+    {
+        std::shared_ptr<const MappedFile> file = OpenShaderFile(path, m_Access);
+        if (!file) {
+            return false;
+        }
+        m_Source.Files.push_back(file);
+        m_Source.FilePaths.push_back(std::filesystem::path(path).lexically_normal().generic_string());
+
+        std::string_view text = file->GetText();
+        size_t runStart = std::string_view::npos; //first plain line of the current run
+        bool warned = false;
+
+        //the run up to end goes to the current stage, with a new line if the file didn't end in one.
+        auto flush = [&](size_t end) {
+            if (runStart != std::string_view::npos && m_Stage >= 0 && end > runStart) {
+                m_Source.Stages[m_Stage].push_back(text.substr(runStart, end - runStart));
+                if (text[end - 1] != '\n') {
+                    m_Source.Stages[m_Stage].push_back("\n");
+                }
+            }
+            runStart = std::string_view::npos;
+        };
+
+        for (size_t position = 0; position < text.size();) {
+            size_t end = text.find('\n', position);
+            size_t next = end == std::string_view::npos ? text.size() : end + 1;
+            std::string_view line = text.substr(position, next - position);
+
+            //most lines are plain text, only the ones starting with '#' need a closer look.
+            size_t first = line.find_first_not_of(" \t");
+            bool directive = first != std::string_view::npos && line[first] == '#';
+            if (directive) {
+                line = line.substr(first);
+            }
+
+            //if we find a new section...
+            if (directive && StartsWith(line, "#shader")) {
+                flush(position);
+                m_Stage = StageFromName(Trim(line.substr(7)));
+                if (m_Stage < 0) {
+                    std::cout << "Unknown stage '" << Trim(line.substr(7)) << "' in " << path << std::endl;
+                }
+            } //if we find the binding point of a uniform block...
+            else if (directive && StartsWith(line, "#binding")) {
+                flush(position);
+                ParseBinding(path, line);
+            } //if we find keywords variants can turn on...
+            else if (directive && StartsWith(line, "#keywords")) {
+                flush(position);
+                ParseKeywords(path, line);
+            } //if we find another file to paste here...
+            else if (directive && StartsWith(line, "#include")) {
+                flush(position);
+                Include(path, line, depth);
+            } //if the line is plain text, it joins the run.
+            else if (m_Stage >= 0) {
+                if (runStart == std::string_view::npos) {
+                    runStart = position;
+                }
+            }
+            else if (!warned && !Trim(line).empty()) {
+                std::cout << "Text outside of a #shader section in " << path << " is ignored" << std::endl;
+                warned = true;
+            }
+
+            position = next;
+        }
+        flush(text.size());
+        return true;
+    }
+private:
+    void ParseBinding(const std::string& path, std::string_view line)
+    {
+        std::istringstream directive(std::string(line.substr(8)));
+        UniformBlockBinding binding;
+        if (directive >> binding.BlockName >> binding.Binding) {
+            m_Source.Bindings.push_back(binding);
+        }
+        else {
+            std::cout << "Malformed '" << Trim(line) << "' in " << path << std::endl;
+        }
+    }
+
+    void ParseKeywords(const std::string& path, std::string_view line)
+    {
+        std::istringstream directive(std::string(line.substr(9)));
+        std::string keyword;
+        while (directive >> keyword) {
+            if (std::find(m_Source.Keywords.begin(), m_Source.Keywords.end(), keyword) != m_Source.Keywords.end()) {
+                continue;
+            }
+            //a variant is a 64 bit mask
+            if (m_Source.Keywords.size() == 64) {
+                std::cout << "More than 64 keywords in " << path << ", " << keyword << " is ignored" << std::endl;
+                continue;
+            }
+            m_Source.Keywords.push_back(keyword);
+        }
+    }
+
+    void Include(const std::string& path, std::string_view line, int depth)
+    {
+        std::string_view name = Trim(line.substr(8));
+        if (name.size() < 2 || !((name.front() == '"' && name.back() == '"') || (name.front() == '<' && name.back() == '>'))) {
+            std::cout << "Malformed '" << Trim(line) << "' in " << path << std::endl;
+            return;
+        }
+        name = name.substr(1, name.size() - 2);
+
+        std::string included = (std::filesystem::path(path).parent_path() / std::filesystem::path(name)).lexically_normal().generic_string();
+
+        //once per stage, like #pragma once
+        if (!m_Included[m_Stage + 1].insert(included).second) {
+            return;
+        }
+        if (depth >= 32) {
+            std::cout << "Includes nested too deep at " << included << " in " << path << std::endl;
+            return;
+        }
+        if (!ParseFile(included, depth + 1)) {
+            std::cout << "Couldn't open " << included << " included from " << path << std::endl;
+        }
+    }
+};
+
+static ShaderProgramSource Parse(const std::string& filepath, MappedFile::Access access)
+{
+    ShaderProgramSource source;
+    ShaderParser parser(source, access);
+    if (!parser.ParseFile(filepath, 0)) {
+        std::cout << "Couldn't open " << filepath << std::endl;
+    }
+    return source;
+}
+
+ShaderProgramSource Shader::ParseShader(const std::string& filepath)
+{
+    return Parse(filepath, MappedFile::Access::Map);
+}
+
+ShaderProgramSource Shader::ReadShader(const std::string& filepath)
+{
+    return Parse(filepath, MappedFile::Access::Read);
+}
+
+std::string ShaderProgramSource::GetStageText(ShaderStage stage) const
+{
+    std::string text;
+    for (std::string_view piece : Stages[(int)stage]) {
+        text.append(piece);
+    }
+    return text;
+}
+
+void ShaderProgramSource::CopyText()
+{
+    std::string* text = new std::string();
+    size_t size = 0;
+    for (const std::vector<std::string_view>& stage : Stages) {
+        for (std::string_view piece : stage) {
+            size += piece.size();
+        }
+    }
+    text->reserve(size);
+
+    //the offsets first: the views can only be made once the string is done growing.
+    size_t starts[(int)ShaderStage::Count];
+    for (int i = 0; i < (int)ShaderStage::Count; i++) {
+        starts[i] = text->size();
+        for (std::string_view piece : Stages[i]) {
+            text->append(piece);
+        }
+    }
+
+    Text.reset(text);
+    for (int i = 0; i < (int)ShaderStage::Count; i++) {
+        if (Stages[i].empty()) {
+            continue;
+        }
+        size_t end = i + 1 < (int)ShaderStage::Count ? starts[i + 1] : text->size();
+        Stages[i].assign(1, std::string_view(*text).substr(starts[i], end - starts[i]));
+    }
+    Files.clear();
+}
+
+unsigned int Shader::CompileShader(ShaderStage stage, const std::vector<std::string_view>& source)
+{
+    unsigned int id = glCreateShader(StageTypes[(int)stage]);
+
+    //the pieces as they are in the mapped files, with their lengths because they don't end in '\0'.
+    std::vector<const char*> pieces(source.size());
+    std::vector<int> lengths(source.size());
+    for (size_t i = 0; i < source.size(); i++) {
+        pieces[i] = source[i].data();
+        lengths[i] = (int)source[i].size();
+    }
+
+    GLCall(glShaderSource(
+        id,                     //id of the shader
+        (int)pieces.size(),     //num of pieces, the driver joins them
+        pieces.data(),          //the pieces
+        lengths.data()          //and how long each one is.
+    ));
+
+    //we don't ask how it went here, GL_COMPILE_STATUS would wait for the compiler.
+    GLCall(glCompileShader(id));
+
+    return id;
+}
+
+//prints the compile log of a shader that failed, false if it did.
+static bool CheckShader(unsigned int id)
+{
+    int result;
+
+    GLCall(glGetShaderiv(
+        id,                 //shader id.
+        GL_COMPILE_STATUS,  //we query whether the compilation was successful.
+        &result             //we store the result here.
+    ));
+
+    //if compilation wasn't successful...
+    if (result == GL_FALSE) {
+        int length;
+        int type;
+
+        GLCall(glGetShaderiv(  //we query the lenght of the message that contains info about the status
+            id,                 //shader id.
+            GL_INFO_LOG_LENGTH, //we query the length of the message.
+            &length             //we store the length here.
+        ));
+        GLCall(glGetShaderiv(id, GL_SHADER_TYPE, &type));
+
+        //we make room in the stack for an array of characters to store the error message.
+        char* message = (char*)alloca((length + 1) * sizeof(char)); //it allocates memory in the stack
+        message[0] = '\0';
+
+        //we get the error message
+        GLCall(glGetShaderInfoLog(
+            id,         //shader id
+            length + 1, //we give the size of the buffer (in case we have another size)
+            &length,    //we get the size of the message
+            message     //the message is set in the buffer.
+        ));
+
+        const char* stage = "unknown";
+        for (int i = 0; i < (int)ShaderStage::Count; i++) {
+            if (StageTypes[i] == (unsigned int)type) {
+                stage = StageNames[i];
+            }
+        }
+        std::cout << "Failed to compile " << stage << " shader!" << std::endl;
+        std::cout << message << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+unsigned int Shader::StartProgram(const ShaderProgramSource& source)
+{
+    unsigned int program = glCreateProgram();
+
+    //the program cache needs the driver to keep the binary around.
+    if (ProgramCache::IsEnabled()) {
+        GLCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+
+    //like compiling a C++ program, one object per stage
+    for (int stage = 0; stage < (int)ShaderStage::Count; stage++) {
+        if (source.HasStage((ShaderStage)stage)) {
+            unsigned int shader = CompileShader((ShaderStage)stage, source.Stages[stage]);
+            GLCall(glAttachShader(program, shader));
+
+            //it's only flagged, the driver frees it when FinishProgram detaches it.
+            GLCall(glDeleteShader(shader));
+        }
+    }
+
+    //like linking a C++ program
+    GLCall(glLinkProgram(program));
+
+    return program;
+}
+
+bool Shader::IsProgramReady(unsigned int program)
+{
+    //without the extension nothing says whether the driver is done, asking anything else waits for it.
+    if (!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile) {
+        return true;
+    }
+
+    int completed = GL_TRUE;
+    GLCall(glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed));
+    return completed == GL_TRUE;
+}
+
+bool Shader::FinishProgram(unsigned int program)
+{
+    int result;
+    GLCall(glGetProgramiv(program, GL_LINK_STATUS, &result));
+
+    //removing the intermediate resources, like Obj files ??
+    unsigned int shaders[(int)ShaderStage::Count];
+    int count = 0;
+    GLCall(glGetAttachedShaders(program, (int)ShaderStage::Count, &count, shaders));
+    for (int i = 0; i < count; i++) {
+        //a stage that didn't compile is why the link failed, its log says more than the link's.
+        if (result == GL_FALSE) {
+            CheckShader(shaders[i]);
+        }
+        GLCall(glDetachShader(program, shaders[i]));
+    }
+
+    if (result == GL_FALSE) {
+        int length;
+        GLCall(glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length));
+
+        std::vector<char> message(length + 1, '\0');
+        GLCall(glGetProgramInfoLog(program, length + 1, &length, message.data()));
+
+        std::cout << "Failed to link program!" << std::endl;
+        std::cout << message.data() << std::endl;
+        return false;
+    }
+
+    GLCall(glValidateProgram(program));
+    return true;
+}
+
+unsigned int Shader::LoadOrCreateProgram(const ShaderProgramSource& source)
+{
+    //a program linked by an earlier run skips compiling and linking altogether.
+    unsigned long long key = ProgramCache::Key(source);
+    unsigned int program = ProgramCache::Load(key);
+    if (!program) {
+        program = CreateShader(source);
+        ProgramCache::Store(key, program);
+    }
+    return program;
+}
+
+/*
+* This function gets the stages in text format and compiles and link them together
+*/
+unsigned int Shader::CreateShader(const ShaderProgramSource& source)
+{
+    unsigned int program = StartProgram(source);
+    FinishProgram(program);
+    return program;
+}
+
+Shader::Shader(const std::string& filepath)
+    : m_FilePath(filepath), m_RendererID(0), m_UniformCount(0)
+{
+    ShaderProgramSource source = ParseShader(filepath);
+    m_RendererID = LoadOrCreateProgram(source);
+    LoadUniforms();
+    BindUniformBlocks(source.Bindings);
+}
+
+Shader::Shader(const std::string& filepath, unsigned int program, const std::vector<UniformBlockBinding>& bindings)
+    : m_FilePath(filepath), m_RendererID(program), m_UniformCount(0)
+{
+    LoadUniforms();
+    BindUniformBlocks(bindings);
+}
+
+void Shader::Replace(unsigned int program, const std::vector<UniformBlockBinding>& bindings)
+{
+    //if the old one is bound it's only flagged, it stays in use until the next Bind.
+    GLState::DeleteProgram(m_RendererID);
+
+    m_RendererID = program;
+    LoadUniforms();
+    BindUniformBlocks(bindings);
+}
+
+Shader::~Shader()
+{
+    GLState::DeleteProgram(m_RendererID);
+}
+
+void Shader::Bind() const
+{
+    GLState::UseProgram(m_RendererID);
+}
+
+void Shader::UnBind() const
+{
+    GLState::UseProgram(0);
+}
+
+/*
+* Connects each uniform or storage block to the binding point the .shader file declared for it,
+* so a buffer bound there with BindBase feeds it.
+*/
+void Shader::BindUniformBlocks(const std::vector<UniformBlockBinding>& bindings)
+{
+    for (const UniformBlockBinding& binding : bindings) {
+        int index = m_Reflection.FindUniformBlock(binding.BlockName.c_str());
+        if (index >= 0) {
+            GLCall(glUniformBlockBinding(m_RendererID, index, binding.Binding));
+            m_Reflection.SetUniformBlockBinding(index, binding.Binding);
+            continue;
+        }
+
+        index = m_Reflection.FindStorageBlock(binding.BlockName.c_str());
+        if (index >= 0) {
+            GLCall(glShaderStorageBlockBinding(m_RendererID, index, binding.Binding));
+            m_Reflection.SetStorageBlockBinding(index, binding.Binding);
+            continue;
+        }
+
+        std::cout << "Uniform block " << binding.BlockName << " isn't used in " << m_FilePath << std::endl;
+    }
+}
+
+bool Shader::Validate(const VertexArray& va) const
+{
+    return m_Reflection.ValidateVertexArray(va, m_FilePath);
+}
+
+void Shader::CheckVertexArray(const VertexArray& va) const
+{
+    //the vertex array remembers which programs it was checked with, so this is a short scan of its own list.
+    if (va.MarkValidated(m_ProgramRevision)) {
+        Validate(va);
+    }
+}
+
+//FNV-1a, it's cheap for the short names uniforms have.
+static unsigned long long HashUniformName(const char* name)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (const char* c = name; *c; c++) {
+        hash ^= (unsigned char)*c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::atomic<unsigned long long> s_NextProgramRevision(1);
+
+/*
+* Reflects the program once, right after linking, and fills the uniform table from it.
+*/
+void Shader::LoadUniforms()
+{
+    m_Reflection.Reflect(m_RendererID);
+    m_ProgramRevision = s_NextProgramRevision++;
+    const std::vector<ShaderUniform>& uniforms = m_Reflection.GetUniforms();
+
+    //it grows by itself if arrays add more entries than this.
+    unsigned int capacity = 16;
+    while (capacity < (unsigned int)uniforms.size() * 2) {
+        capacity *= 2;
+    }
+    m_Uniforms.assign(capacity, { 0, Empty, -1 });
+    m_UniformNames.clear();
+    m_UniformCount = 0;
+
+    for (const ShaderUniform& uniform : uniforms) {
+        if (uniform.Location == -1) {
+            continue; //it lives in a block
+        }
+
+        std::string name = m_Reflection.GetName(uniform.Name);
+        AddUniform(name.c_str(), uniform.Location);
+
+        //arrays are reported as "name[0]", we also accept "name" and every "name[i]".
+        size_t bracket = name.find('[');
+        if (bracket != std::string::npos) {
+            std::string base = name.substr(0, bracket);
+            AddUniform(base.c_str(), uniform.Location);
+
+            for (int element = 1; element < uniform.ArraySize; element++) {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                int elementLocation = GLCallValue(glGetUniformLocation(m_RendererID, elementName.c_str()));
+                AddUniform(elementName.c_str(), elementLocation);
+            }
+        }
+    }
+}
+
+void Shader::AddUniform(const char* name, int location)
+{
+    //we keep the load factor under 1/2 so the probes stay short.
+    if ((m_UniformCount + 1) * 2 > m_Uniforms.size()) {
+        std::vector<UniformSlot> old(m_Uniforms.size() * 2, { 0, Empty, -1 });
+        old.swap(m_Uniforms);
+
+        unsigned int mask = (unsigned int)m_Uniforms.size() - 1;
+        for (const UniformSlot& slot : old) {
+            if (slot.name != Empty) {
+                unsigned int i = (unsigned int)slot.hash & mask;
+                while (m_Uniforms[i].name != Empty) {
+                    i = (i + 1) & mask;
+                }
+                m_Uniforms[i] = slot;
+            }
+        }
+    }
+
+    unsigned long long hash = HashUniformName(name);
+    unsigned int mask = (unsigned int)m_Uniforms.size() - 1;
+
+    for (unsigned int i = (unsigned int)hash & mask;; i = (i + 1) & mask) {
+        UniformSlot& slot = m_Uniforms[i];
+        if (slot.name == Empty) {
+            slot = { hash, (unsigned int)m_UniformNames.size(), location };
+            m_UniformNames.append(name);
+            m_UniformNames.push_back('\0');
+            m_UniformCount++;
+            return;
+        }
+        if (slot.hash == hash && strcmp(&m_UniformNames[slot.name], name) == 0) {
+            return;
+        }
+    }
+}
+
+int Shader::GetUniformLocation(const char* name) const
+{
+    unsigned long long hash = HashUniformName(name);
+    unsigned int mask = (unsigned int)m_Uniforms.size() - 1;
+
+    for (unsigned int i = (unsigned int)hash & mask;; i = (i + 1) & mask) {
+        const UniformSlot& slot = m_Uniforms[i];
+        if (slot.name == Empty) {
+            return -1;
+        }
+        if (slot.hash == hash && strcmp(&m_UniformNames[slot.name], name) == 0) {
+            return slot.location;
+        }
+    }
+}
+
+void Shader::SetUniform1i(const char* name, int value)
+{
+    GLCall(glUniform1i(GetUniformLocation(name), value));
+}
+
+void Shader::SetUniform1iv(const char* name, int count, const int* values)
+{
+    GLCall(glUniform1iv(GetUniformLocation(name), count, values));
+}
+
+void Shader::SetUniform1f(const char* name, float value)
+{
+    GLCall(glUniform1f(GetUniformLocation(name), value));
+}
+
+void Shader::SetUniform2f(const char* name, float v0, float v1)
+{
+    GLCall(glUniform2f(GetUniformLocation(name), v0, v1));
+}
+
+void Shader::SetUniform3f(const char* name, float v0, float v1, float v2)
+{
+    GLCall(glUniform3f(GetUniformLocation(name), v0, v1, v2));
+}
+
+void Shader::SetUniform4f(const char* name, float v0, float v1, float v2, float v3)
+{
+    GLCall(glUniform4f(GetUniformLocation(name), v0, v1, v2, v3));
+}
+
+void Shader::SetUniformMat4f(const char* name, const float* matrix)
+{
+    GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, matrix));
+}
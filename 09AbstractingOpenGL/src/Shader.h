@@ -0,0 +1,143 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+#include "ShaderReflection.h"
+
+class MappedFile;
+class VertexArray;
+
+//a "#binding BlockName N" line of a .shader file
+struct UniformBlockBinding
+{
+	std::string BlockName;
+	unsigned int Binding;
+};
+
+//the "#shader NAME" sections a .shader file can have
+enum class ShaderStage
+{
+	Vertex,
+	TessControl,
+	TessEvaluation,
+	Geometry,
+	Fragment,
+	Compute,
+	Count
+};
+
+/*
+* Each stage is a list of pieces of the mapped .shader file and the files it includes, in order.
+* glShaderSource takes them as they are, so the text is never copied. Files keeps them mapped.
+* The mapping follows the file, so a source kept while the file may be saved again has to CopyText first.
+* Sources from ReadShader hold copies of the files, they don't change.
+*/
+struct ShaderProgramSource
+{
+	std::vector<std::string_view> Stages[(int)ShaderStage::Count];
+	std::vector<UniformBlockBinding> Bindings;
+	std::vector<std::shared_ptr<const MappedFile>> Files;
+	std::vector<std::string> FilePaths;	//the path of each of the Files, the .shader file first
+	std::vector<std::string> Keywords;	//"#keywords A B" lines, in order. ShaderVariants turns them into #defines
+	std::shared_ptr<const std::string> Text;	//every stage, after CopyText
+
+	inline bool HasStage(ShaderStage stage) const { return !Stages[(int)stage].empty(); }
+	std::string GetStageText(ShaderStage stage) const; //the pieces joined, for error messages and tools
+
+	//copies the stages into Text and lets go of the files, so saving them can't change or truncate what Stages points to.
+	void CopyText();
+};
+
+class Shader
+{
+private:
+	//a slot of the uniform table. The table is open addressing with linear probing.
+	struct UniformSlot
+	{
+		unsigned long long hash;
+		unsigned int name;	//offset in m_UniformNames, Empty if the slot is free
+		int location;
+	};
+
+	static const unsigned int Empty = 0xFFFFFFFF;
+
+	std::string m_FilePath;
+	unsigned int m_RendererID;
+	std::vector<UniformSlot> m_Uniforms;	//its size is a power of 2
+	unsigned int m_UniformCount;
+	std::string m_UniformNames;				//all the names one after the other, each one ending in '\0'
+	ShaderReflection m_Reflection;
+	unsigned long long m_ProgramRevision;	//new on every link, and never used by another shader, see VertexArray::MarkValidated
+
+	void LoadUniforms();
+	void BindUniformBlocks(const std::vector<UniformBlockBinding>& bindings);
+	void AddUniform(const char* name, int location);
+
+	/*
+	* Creating a program is split so ShaderQueue can leave the driver compiling: StartProgram compiles
+	* every stage and links without asking how it went, IsProgramReady doesn't wait, and FinishProgram
+	* reports the errors and frees the stages. CreateShader does the three at once.
+	*/
+	static unsigned int CompileShader(ShaderStage stage, const std::vector<std::string_view>& source);
+	static unsigned int StartProgram(const ShaderProgramSource& source);
+	static bool IsProgramReady(unsigned int program);
+	static bool FinishProgram(unsigned int program);	//false if it didn't link
+	static unsigned int CreateShader(const ShaderProgramSource& source);
+	//from the ProgramCache if it's there, otherwise compiled, linked and stored in it.
+	static unsigned int LoadOrCreateProgram(const ShaderProgramSource& source);
+
+	//wraps a program that is already linked
+	Shader(const std::string& filepath, unsigned int program, const std::vector<UniformBlockBinding>& bindings);
+
+	//deletes the current program and takes this one, which must be linked. The uniforms are looked up again
+	//and start at their defaults, and it has to be bound again.
+	void Replace(unsigned int program, const std::vector<UniformBlockBinding>& bindings);
+
+	friend class ShaderQueue;
+	friend class ShaderWatcher;
+	friend class ShaderVariants;
+public:
+	Shader(const std::string& filepath);
+	~Shader();
+
+	void Bind() const;
+	void UnBind() const;
+
+	//it never calls the driver, the locations were resolved when the program was linked. -1 if there is no such uniform.
+	int GetUniformLocation(const char* name) const;
+
+	void SetUniform1i(const char* name, int value);
+	void SetUniform1iv(const char* name, int count, const int* values);
+	void SetUniform1f(const char* name, float value);
+	void SetUniform2f(const char* name, float v0, float v1);
+	void SetUniform3f(const char* name, float v0, float v1, float v2);
+	void SetUniform4f(const char* name, float v0, float v1, float v2, float v3);
+	void SetUniformMat4f(const char* name, const float* matrix);
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline const ShaderReflection& GetReflection() const { return m_Reflection; }
+	//unlike GL program names, revisions aren't reused after a program is deleted or replaced.
+	inline unsigned long long GetProgramRevision() const { return m_ProgramRevision; }
+
+	//the vertex array feeds every input, see ShaderReflection::ValidateVertexArray.
+	bool Validate(const VertexArray& va) const;
+	//Validate, the first time it sees a vertex array or after buffers were added to it. The Renderer calls it before
+	//drawing unless GLCall is in release mode.
+	void CheckVertexArray(const VertexArray& va) const;
+
+	/*
+	* Maps the file and splits it in "#shader vertex", "tesscontrol", "tesseval", "geometry", "fragment" or
+	* "compute" sections. '#include "file"' (relative to the including file) inserts a file once per stage,
+	* "#binding Block N" lines give uniform blocks their binding points and "#keywords A B" lines declare
+	* the keywords of ShaderVariants. Files stay mapped between calls until they change on disk, so a file
+	* included by many shaders is only opened once.
+	*/
+	static ShaderProgramSource ParseShader(const std::string& filepath);
+	//ParseShader, but the files are read into memory of the source's own instead of mapped, and the cache isn't used.
+	//For threads that parse right after a file is saved, when it may be written again while they parse.
+	static ShaderProgramSource ReadShader(const std::string& filepath);
+};
@@ -0,0 +1,99 @@
+#include "ShaderQueue.h"
+#include "Renderer.h"
+#include "ProgramCache.h"
+
+#include <algorithm>
+
+ShaderQueue::ShaderQueue()
+    : m_Parallel(false)
+{
+    //0xFFFFFFFF means "as many as the implementation wants".
+    if (GLEW_KHR_parallel_shader_compile) {
+        GLCall(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+        m_Parallel = true;
+    }
+    else if (GLEW_ARB_parallel_shader_compile) {
+        GLCall(glMaxShaderCompilerThreadsARB(0xFFFFFFFF));
+        m_Parallel = true;
+    }
+}
+
+ShaderQueue::~ShaderQueue()
+{
+    WaitAll();
+}
+
+ShaderQueue::Handle ShaderQueue::Add(const std::string& filepath)
+{
+    Handle handle;
+    handle.m_Build = std::make_shared<Build>();
+    Build& build = *handle.m_Build;
+    build.filepath = filepath;
+    build.failed = false;
+
+    //the driver copies the text in glShaderSource, so the mapped files can go once this returns.
+    ShaderProgramSource source = Shader::ParseShader(filepath);
+    build.bindings = source.Bindings;
+    build.key = ProgramCache::Key(source);
+
+    //a program linked by an earlier run is ready right away.
+    build.program = ProgramCache::Load(build.key);
+    if (build.program) {
+        build.shader.reset(new Shader(filepath, build.program, build.bindings));
+        return handle;
+    }
+
+    build.program = Shader::StartProgram(source);
+    m_Pending.push_back(handle.m_Build);
+    return handle;
+}
+
+void ShaderQueue::Finish(Build& build)
+{
+    build.failed = !Shader::FinishProgram(build.program);
+    if (!build.failed) {
+        ProgramCache::Store(build.key, build.program);
+    }
+    build.shader.reset(new Shader(build.filepath, build.program, build.bindings));
+}
+
+unsigned int ShaderQueue::Poll()
+{
+    unsigned int finished = 0;
+    for (size_t i = 0; i < m_Pending.size();) {
+        Build& build = *m_Pending[i];
+
+        //without the extension IsProgramReady says yes to everything, so we stop after one.
+        if ((m_Parallel || finished == 0) && Shader::IsProgramReady(build.program)) {
+            Finish(build);
+            m_Pending.erase(m_Pending.begin() + i);
+            finished++;
+        }
+        else {
+            i++;
+        }
+    }
+    return finished;
+}
+
+Shader& ShaderQueue::Wait(const Handle& handle)
+{
+    ASSERT(handle.m_Build);
+
+    if (!handle.m_Build->shader) {
+        //a build still pending has to be one of ours, the handle of another queue would be finished twice.
+        auto pending = std::find(m_Pending.begin(), m_Pending.end(), handle.m_Build);
+        ASSERT(pending != m_Pending.end());
+        Finish(*handle.m_Build);
+        m_Pending.erase(pending);
+    }
+    return *handle.m_Build->shader;
+}
+
+void ShaderQueue::WaitAll()
+{
+    for (const std::shared_ptr<Build>& build : m_Pending) {
+        Finish(*build);
+    }
+    m_Pending.clear();
+}
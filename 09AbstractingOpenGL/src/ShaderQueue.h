@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "Shader.h"
+
+/*
+* Builds shaders without waiting for the driver. Add compiles and links a file right away but doesn't
+* ask how it went, so the driver compiles while we do other things (with GL_KHR_parallel_shader_compile
+* it does it on its own threads). Poll, once per frame, turns the programs that are done into Shaders.
+*
+*   ShaderQueue queue;
+*   ShaderQueue::Handle basic = queue.Add("res/shaders/Basic.shader");
+*   ...load the meshes and textures...
+*   Shader& shader = queue.Wait(basic);
+*
+* or, to never stall a frame:
+*
+*   queue.Poll();
+*   if (basic.IsReady()) {
+*       basic.Get()->Bind();
+*   }
+*
+* Programs in the ProgramCache are ready as soon as they are added. Like the Shader constructor, a
+* program that fails still becomes a Shader, the errors are printed when it is finished.
+*/
+class ShaderQueue
+{
+private:
+	struct Build
+	{
+		std::string filepath;
+		unsigned long long key;
+		unsigned int program;
+		std::vector<UniformBlockBinding> bindings;
+		std::unique_ptr<Shader> shader;	//set once it is finished
+		bool failed;
+	};
+
+	std::vector<std::shared_ptr<Build>> m_Pending;	//in the order they were added
+	bool m_Parallel;								//the driver tells when a program is done
+
+	void Finish(Build& build);
+public:
+	//like a future: it's ready when the Shader exists. Copies share the same Shader.
+	class Handle
+	{
+	private:
+		std::shared_ptr<Build> m_Build;
+
+		friend class ShaderQueue;
+	public:
+		inline bool IsReady() const { return m_Build && m_Build->shader; }
+		inline bool Failed() const { return IsReady() && m_Build->failed; }
+
+		//nullptr until it's ready
+		inline Shader* Get() const { return IsReady() ? m_Build->shader.get() : nullptr; }
+	};
+
+	//lets the driver use as many compiler threads as it likes.
+	ShaderQueue();
+	//finishes whatever is left, so the handles still get their Shaders.
+	~ShaderQueue();
+
+	ShaderQueue(const ShaderQueue&) = delete;
+	ShaderQueue& operator=(const ShaderQueue&) = delete;
+
+	Handle Add(const std::string& filepath);
+
+	/*
+	* Finishes the programs the driver is done with and returns how many. Without the extension there is no
+	* way to know without waiting, so it finishes the oldest one only and the stalls spread over the frames.
+	*/
+	unsigned int Poll();
+
+	//finishes this one now, waiting for the driver if it has to. The handle must come from Add of this queue.
+	Shader& Wait(const Handle& handle);
+	void WaitAll();
+
+	inline size_t GetPendingCount() const { return m_Pending.size(); }
+	inline bool IsParallel() const { return m_Parallel; }
+};
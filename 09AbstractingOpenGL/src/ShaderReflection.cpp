@@ -0,0 +1,219 @@
+#include "ShaderReflection.h"
+#include "Renderer.h"
+#include "VertexArray.h"
+
+#include <iostream>
+#include <cstring>
+
+unsigned int ShaderReflection::AddName(const char* name)
+{
+    unsigned int offset = (unsigned int)m_Names.size();
+    m_Names.append(name);
+    m_Names.push_back('\0');
+    return offset;
+}
+
+void ShaderReflection::Reflect(unsigned int program)
+{
+    m_Attributes.clear();
+    m_Uniforms.clear();
+    m_UniformBlocks.clear();
+    m_StorageBlocks.clear();
+    m_Names.clear();
+
+    if (GLEW_VERSION_4_3 || GLEW_ARB_program_interface_query) {
+        ReflectInterfaces(program);
+    }
+    else {
+        ReflectLegacy(program);
+    }
+}
+
+void ShaderReflection::ReflectInterfaces(unsigned int program)
+{
+    //one buffer for the names, as long as the longest of any interface.
+    const GLenum interfaces[] = { GL_PROGRAM_INPUT, GL_UNIFORM, GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK };
+    int maxLength = 1;
+    for (GLenum programInterface : interfaces) {
+        int length = 0;
+        GLCall(glGetProgramInterfaceiv(program, programInterface, GL_MAX_NAME_LENGTH, &length));
+        maxLength = length > maxLength ? length : maxLength;
+    }
+    std::vector<char> name(maxLength + 1);
+
+    int count = 0;
+    GLCall(glGetProgramInterfaceiv(program, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES, &count));
+    for (int i = 0; i < count; i++) {
+        const GLenum properties[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION };
+        int values[3];
+        GLCall(glGetProgramResourceiv(program, GL_PROGRAM_INPUT, i, 3, properties, 3, nullptr, values));
+        GLCall(glGetProgramResourceName(program, GL_PROGRAM_INPUT, i, (int)name.size(), nullptr, name.data()));
+        m_Attributes.push_back({ AddName(name.data()), values[2], (unsigned int)values[0], values[1] });
+    }
+
+    GLCall(glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count));
+    for (int i = 0; i < count; i++) {
+        const GLenum properties[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX, GL_OFFSET };
+        int values[5];
+        GLCall(glGetProgramResourceiv(program, GL_UNIFORM, i, 5, properties, 5, nullptr, values));
+        GLCall(glGetProgramResourceName(program, GL_UNIFORM, i, (int)name.size(), nullptr, name.data()));
+        m_Uniforms.push_back({ AddName(name.data()), values[2], (unsigned int)values[0], values[1], values[3], values[3] >= 0 ? values[4] : -1 });
+    }
+
+    //uniform and storage blocks answer the same properties.
+    const GLenum blockInterfaces[] = { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK };
+    std::vector<ShaderBlock>* blockTables[] = { &m_UniformBlocks, &m_StorageBlocks };
+    for (int table = 0; table < 2; table++) {
+        GLCall(glGetProgramInterfaceiv(program, blockInterfaces[table], GL_ACTIVE_RESOURCES, &count));
+        for (int i = 0; i < count; i++) {
+            const GLenum properties[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES };
+            int values[3];
+            GLCall(glGetProgramResourceiv(program, blockInterfaces[table], i, 3, properties, 3, nullptr, values));
+            GLCall(glGetProgramResourceName(program, blockInterfaces[table], i, (int)name.size(), nullptr, name.data()));
+            blockTables[table]->push_back({ AddName(name.data()), values[0], values[1], values[2] });
+        }
+    }
+}
+
+void ShaderReflection::ReflectLegacy(unsigned int program)
+{
+    int count = 0;
+    int maxLength = 0;
+    GLCall(glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count));
+    GLCall(glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength));
+    std::vector<char> name(maxLength + 1);
+    for (int i = 0; i < count; i++) {
+        int size = 0;
+        GLenum type;
+        GLCall(glGetActiveAttrib(program, i, (int)name.size(), nullptr, &size, &type, name.data()));
+        int location = GLCallValue(glGetAttribLocation(program, name.data()));
+        m_Attributes.push_back({ AddName(name.data()), location, type, size });
+    }
+
+    GLCall(glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count));
+    GLCall(glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+    name.resize(maxLength + 1);
+    for (int i = 0; i < count; i++) {
+        int size = 0;
+        GLenum type;
+        GLCall(glGetActiveUniform(program, i, (int)name.size(), nullptr, &size, &type, name.data()));
+        int location = GLCallValue(glGetUniformLocation(program, name.data()));
+
+        unsigned int index = i;
+        int blockIndex = -1;
+        int offset = -1;
+        GLCall(glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex));
+        if (blockIndex >= 0) {
+            GLCall(glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_OFFSET, &offset));
+        }
+        m_Uniforms.push_back({ AddName(name.data()), location, type, size, blockIndex, offset });
+    }
+
+    GLCall(glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count));
+    GLCall(glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength));
+    name.resize(maxLength + 1);
+    for (int i = 0; i < count; i++) {
+        ShaderBlock block;
+        GLCall(glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_BINDING, &block.Binding));
+        GLCall(glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.DataSize));
+        GLCall(glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &block.VariableCount));
+        GLCall(glGetActiveUniformBlockName(program, i, (int)name.size(), nullptr, name.data()));
+        block.Name = AddName(name.data());
+        m_UniformBlocks.push_back(block);
+    }
+}
+
+int ShaderReflection::FindUniformBlock(const char* name) const
+{
+    for (size_t i = 0; i < m_UniformBlocks.size(); i++) {
+        if (strcmp(GetName(m_UniformBlocks[i].Name), name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int ShaderReflection::FindStorageBlock(const char* name) const
+{
+    for (size_t i = 0; i < m_StorageBlocks.size(); i++) {
+        if (strcmp(GetName(m_StorageBlocks[i].Name), name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+//how many locations an attribute of this type takes (a matrix one per column), and whether the shader reads it as integers.
+static void AttributeShape(unsigned int type, int& locations, bool& integer)
+{
+    locations = 1;
+    integer = false;
+    switch (type) {
+    case GL_FLOAT_MAT2: case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4:
+        locations = 2;
+        break;
+    case GL_FLOAT_MAT3: case GL_FLOAT_MAT3x2: case GL_FLOAT_MAT3x4:
+        locations = 3;
+        break;
+    case GL_FLOAT_MAT4: case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3:
+        locations = 4;
+        break;
+    case GL_INT: case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+    case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+        integer = true;
+        break;
+    }
+}
+
+bool ShaderReflection::ValidateVertexArray(const VertexArray& va, const std::string& label) const
+{
+    bool valid = true;
+    for (const ShaderAttribute& attribute : m_Attributes) {
+        //built-ins like gl_VertexID don't come from buffers.
+        if (attribute.Location < 0) {
+            continue;
+        }
+
+        int locations;
+        bool integer;
+        AttributeShape(attribute.Type, locations, integer);
+
+        for (int i = 0; i < locations * attribute.ArraySize; i++) {
+            unsigned int location = (unsigned int)(attribute.Location + i);
+            const VertexAttribute* fed = va.GetAttribute(location);
+            if (!fed) {
+                std::cout << label << ": attribute " << GetName(attribute.Name) << " (location " << location
+                    << ") isn't in the vertex array" << std::endl;
+                valid = false;
+            }
+            else if (fed->Integer != integer) {
+                std::cout << label << ": attribute " << GetName(attribute.Name) << " (location " << location << ") is "
+                    << (integer ? "an integer" : "a float") << " in the shader but the vertex array gives "
+                    << (fed->Integer ? "integers" : "floats") << std::endl;
+                valid = false;
+            }
+        }
+    }
+    return valid;
+}
+
+void ShaderReflection::Print(std::ostream& stream) const
+{
+    for (const ShaderAttribute& attribute : m_Attributes) {
+        stream << "  in " << GetName(attribute.Name) << ": location " << attribute.Location
+            << ", type 0x" << std::hex << attribute.Type << std::dec << ", size " << attribute.ArraySize << std::endl;
+    }
+    for (const ShaderUniform& uniform : m_Uniforms) {
+        stream << "  uniform " << GetName(uniform.Name) << ": location " << uniform.Location
+            << ", type 0x" << std::hex << uniform.Type << std::dec << ", size " << uniform.ArraySize
+            << ", block " << uniform.BlockIndex << ", offset " << uniform.Offset << std::endl;
+    }
+    for (const ShaderBlock& block : m_UniformBlocks) {
+        stream << "  uniform block " << GetName(block.Name) << ": binding " << block.Binding << ", "
+            << block.DataSize << " bytes, " << block.VariableCount << " variables" << std::endl;
+    }
+    for (const ShaderBlock& block : m_StorageBlocks) {
+        stream << "  storage block " << GetName(block.Name) << ": binding " << block.Binding << ", "
+            << block.DataSize << " bytes, " << block.VariableCount << " variables" << std::endl;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+class VertexArray;
+
+//an active vertex shader input
+struct ShaderAttribute
+{
+	unsigned int Name;		//offset in the names of the reflection
+	int Location;			//-1 for built-ins like gl_VertexID
+	unsigned int Type;		//GL_FLOAT_VEC3, GL_INT...
+	int ArraySize;
+};
+
+//an active uniform, in the default block or in a uniform block
+struct ShaderUniform
+{
+	unsigned int Name;
+	int Location;			//-1 inside a block
+	unsigned int Type;
+	int ArraySize;
+	int BlockIndex;			//-1 in the default block
+	int Offset;				//bytes from the start of the block, -1 in the default block
+};
+
+//an active uniform or shader storage block
+struct ShaderBlock
+{
+	unsigned int Name;
+	int Binding;
+	int DataSize;			//bytes, for storage blocks without the unsized array at the end
+	int VariableCount;
+};
+
+/*
+* What a linked program uses, asked once after linking (glGetProgramInterfaceiv and glGetProgramResourceiv
+* on GL 4.3, the older glGetActive* calls otherwise, which know nothing of storage blocks). Every kind goes
+* in its own flat table in the order the driver lists it, and all the names in one string.
+*/
+class ShaderReflection
+{
+private:
+	std::vector<ShaderAttribute> m_Attributes;
+	std::vector<ShaderUniform> m_Uniforms;
+	std::vector<ShaderBlock> m_UniformBlocks;
+	std::vector<ShaderBlock> m_StorageBlocks;
+	std::string m_Names;	//each one ending in '\0'
+
+	unsigned int AddName(const char* name);
+	void ReflectInterfaces(unsigned int program);
+	void ReflectLegacy(unsigned int program);
+public:
+	void Reflect(unsigned int program);
+
+	inline const char* GetName(unsigned int name) const { return &m_Names[name]; }
+
+	inline const std::vector<ShaderAttribute>& GetAttributes() const { return m_Attributes; }
+	inline const std::vector<ShaderUniform>& GetUniforms() const { return m_Uniforms; }
+	inline const std::vector<ShaderBlock>& GetUniformBlocks() const { return m_UniformBlocks; }
+	inline const std::vector<ShaderBlock>& GetStorageBlocks() const { return m_StorageBlocks; }
+
+	//index in the table, -1 if it isn't active.
+	int FindUniformBlock(const char* name) const;
+	int FindStorageBlock(const char* name) const;
+
+	//keeps the tables in step with glUniformBlockBinding and glShaderStorageBlockBinding.
+	inline void SetUniformBlockBinding(int index, int binding) { m_UniformBlocks[index].Binding = binding; }
+	inline void SetStorageBlockBinding(int index, int binding) { m_StorageBlocks[index].Binding = binding; }
+
+	/*
+	* Checks that the vertex array feeds every attribute the shader reads, and as integers the ones
+	* it declares int or uint. Prints what's wrong (label says which shader) and returns false.
+	*/
+	bool ValidateVertexArray(const VertexArray& va, const std::string& label) const;
+
+	//all the tables, for debugging
+	void Print(std::ostream& stream) const;
+};
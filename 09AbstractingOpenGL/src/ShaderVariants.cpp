@@ -0,0 +1,80 @@
+#include "ShaderVariants.h"
+#include "Renderer.h"
+
+#include <iostream>
+
+ShaderVariants::ShaderVariants(const std::string& filepath)
+    : m_FilePath(filepath), m_Source(Shader::ParseShader(filepath)), m_ValidMask(0)
+{
+    //variants are created for as long as this lives, the mapping of the file would follow later saves.
+    m_Source.CopyText();
+
+    size_t count = m_Source.Keywords.size();
+    m_ValidMask = count >= 64 ? ~0ull : (1ull << count) - 1;
+}
+
+unsigned long long ShaderVariants::GetKeywordBit(const std::string& keyword) const
+{
+    for (size_t i = 0; i < m_Source.Keywords.size(); i++) {
+        if (m_Source.Keywords[i] == keyword) {
+            return 1ull << i;
+        }
+    }
+
+    std::cout << "Keyword " << keyword << " isn't declared in " << m_FilePath << std::endl;
+    return 0;
+}
+
+/*
+* Splits the piece with the #version line of a stage after that line, and puts defines in between.
+* GLSL wants #version first, so a stage without one gets them at the top.
+*/
+static void InsertDefines(std::vector<std::string_view>& stage, std::string_view defines)
+{
+    for (size_t i = 0; i < stage.size(); i++) {
+        std::string_view piece = stage[i];
+        size_t version = piece.find("#version");
+        if (version == std::string_view::npos) {
+            continue;
+        }
+
+        size_t end = piece.find('\n', version);
+        end = end == std::string_view::npos ? piece.size() : end + 1;
+
+        stage[i] = piece.substr(0, end);
+        stage.insert(stage.begin() + i + 1, defines);
+        if (end < piece.size()) {
+            stage.insert(stage.begin() + i + 2, piece.substr(end));
+        }
+        return;
+    }
+
+    stage.insert(stage.begin(), defines);
+}
+
+Shader& ShaderVariants::Create(unsigned long long mask)
+{
+    ASSERT((mask & ~m_ValidMask) == 0); //a bit without a keyword
+
+    std::string defines;
+    for (size_t i = 0; i < m_Source.Keywords.size(); i++) {
+        if (mask & (1ull << i)) {
+            defines += "#define " + m_Source.Keywords[i] + "\n";
+        }
+    }
+
+    //the same pieces of the mapped files, plus the defines. They change the ProgramCache key too.
+    ShaderProgramSource source = m_Source;
+    if (!defines.empty()) {
+        for (std::vector<std::string_view>& stage : source.Stages) {
+            if (!stage.empty()) {
+                InsertDefines(stage, defines);
+            }
+        }
+    }
+
+    unsigned int program = Shader::LoadOrCreateProgram(source);
+    std::unique_ptr<Shader>& variant = m_Variants[mask];
+    variant.reset(new Shader(m_FilePath, program, m_Source.Bindings));
+    return *variant;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "Shader.h"
+
+/*
+* All the variants of a .shader file that declares keywords:
+*
+*   #keywords TEXTURED VERTEX_COLOR INSTANCING
+*
+* A variant is a mask with one bit per keyword, in the order they are declared. The keywords of the
+* mask are #defined right after the #version line of every stage, so the source uses #ifdef TEXTURED.
+* A variant is compiled the first time it's asked for (or loaded from the ProgramCache) and kept.
+*
+*   ShaderVariants surface("res/shaders/Surface.shader");
+*   unsigned long long textured = surface.GetKeywordBit("TEXTURED");   //once, at setup
+*   ...
+*   Shader& shader = surface.Get(textured | vertexColor);             //in the draw loop, no strings
+*
+* The file is parsed once and its text copied, so later variants don't read it again and saving it
+* while the program runs can't change what they compile.
+*/
+class ShaderVariants
+{
+private:
+	std::string m_FilePath;
+	ShaderProgramSource m_Source;
+	unsigned long long m_ValidMask;	//the bits of the declared keywords
+	std::unordered_map<unsigned long long, std::unique_ptr<Shader>> m_Variants;
+
+	Shader& Create(unsigned long long mask);
+public:
+	ShaderVariants(const std::string& filepath);
+
+	//the bit of a keyword, 0 (and a message) if the file doesn't declare it.
+	unsigned long long GetKeywordBit(const std::string& keyword) const;
+	inline const std::vector<std::string>& GetKeywords() const { return m_Source.Keywords; }
+
+	//one hash lookup once the variant exists.
+	inline Shader& Get(unsigned long long mask)
+	{
+		auto it = m_Variants.find(mask);
+		return it != m_Variants.end() ? *it->second : Create(mask);
+	}
+
+	inline size_t GetVariantCount() const { return m_Variants.size(); }
+};
@@ -0,0 +1,278 @@
+#include "ShaderWatcher.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "ProgramCache.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+//editors save in several steps (truncate, write, rename...), we wait for them to settle before parsing.
+static const std::chrono::milliseconds SettleTime(50);
+
+ShaderWatcher::ShaderWatcher()
+    : m_Running(true), m_Reloads(0), m_Failures(0)
+{
+    m_Thread = std::thread(&ShaderWatcher::Run, this);
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+    m_Running = false;
+    m_Thread.join();
+
+    for (Building& building : m_Building) {
+        GLState::DeleteProgram(building.program);
+    }
+}
+
+void ShaderWatcher::Watch(Shader& shader)
+{
+    //the thread parses it once to know what it includes.
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Shaders.push_back({ &shader, shader.GetFilePath(), {} });
+}
+
+void ShaderWatcher::Unwatch(Shader& shader)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Shaders.erase(std::remove_if(m_Shaders.begin(), m_Shaders.end(),
+            [&](const Watched& watched) { return watched.shader == &shader; }), m_Shaders.end());
+        m_Parsed.erase(std::remove_if(m_Parsed.begin(), m_Parsed.end(),
+            [&](const Parsed& parsed) { return parsed.shader == &shader; }), m_Parsed.end());
+    }
+
+    for (size_t i = 0; i < m_Building.size();) {
+        if (m_Building[i].shader == &shader) {
+            GLState::DeleteProgram(m_Building[i].program);
+            m_Building.erase(m_Building.begin() + i);
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+void ShaderWatcher::Parse(const std::vector<std::string>& changed)
+{
+    std::unordered_set<std::string> changedSet(changed.begin(), changed.end());
+
+    //we pick what to parse with the lock, but parse without it so Update never waits for the files.
+    std::vector<std::pair<Shader*, std::string>> pending;
+    std::vector<bool> reload;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (const Watched& watched : m_Shaders) {
+            bool used = false;
+            for (const std::string& dependency : watched.dependencies) {
+                used = used || changedSet.count(dependency) > 0;
+            }
+            if (used || watched.dependencies.empty()) {
+                pending.push_back({ watched.shader, watched.path });
+                reload.push_back(used);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < pending.size(); i++) {
+        //read, not mapped: the file may be saved again while we parse it, or before the GL thread compiles it.
+        ShaderProgramSource source = Shader::ReadShader(pending[i].second);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (Watched& watched : m_Shaders) {
+            if (watched.shader == pending[i].first) {
+                //a file caught halfway through a save, the next change brings it back.
+                if (source.FilePaths.empty()) {
+                    if (watched.dependencies.empty()) {
+                        watched.dependencies.push_back(watched.path);
+                    }
+                    break;
+                }
+
+                watched.dependencies = source.FilePaths;
+                if (reload[i]) {
+                    //only the newest version of a shader is worth compiling.
+                    m_Parsed.erase(std::remove_if(m_Parsed.begin(), m_Parsed.end(),
+                        [&](const Parsed& parsed) { return parsed.shader == watched.shader; }), m_Parsed.end());
+                    m_Parsed.push_back({ watched.shader, std::move(source) });
+                }
+                break;
+            }
+        }
+    }
+}
+
+#ifdef __linux__
+
+void ShaderWatcher::Run()
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        std::cout << "ShaderWatcher: inotify_init1 failed, shaders won't reload" << std::endl;
+        return;
+    }
+
+    std::unordered_map<int, std::string> directories;  //watch descriptor to the directory it watches
+    std::unordered_set<std::string> watchedDirectories;
+
+    //reads every event there is and returns the paths that changed.
+    auto readEvents = [&](std::vector<std::string>& changed) {
+        alignas(inotify_event) char buffer[sizeof(inotify_event) + NAME_MAX + 1];
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char* event = buffer; event < buffer + length;) {
+                const inotify_event* info = (const inotify_event*)event;
+                auto it = directories.find(info->wd);
+                if (it != directories.end() && info->len > 0) {
+                    changed.push_back((std::filesystem::path(it->second) / info->name).lexically_normal().generic_string());
+                }
+                event += sizeof(inotify_event) + info->len;
+            }
+        }
+    };
+
+    while (m_Running) {
+        //new shaders get parsed once, and the directories of all the files get watched.
+        Parse({});
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (const Watched& watched : m_Shaders) {
+                for (const std::string& dependency : watched.dependencies) {
+                    std::string directory = std::filesystem::path(dependency).parent_path().generic_string();
+                    if (directory.empty()) {
+                        directory = ".";
+                    }
+                    if (watchedDirectories.insert(directory).second) {
+                        //the events come for the directory, so editors that save to a temporary file and rename it count too.
+                        int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+                        if (wd >= 0) {
+                            directories[wd] = directory == "." ? "" : directory;
+                        }
+                    }
+                }
+            }
+        }
+
+        //we wake up now and then to see if we have to stop.
+        pollfd descriptor = { fd, POLLIN, 0 };
+        if (poll(&descriptor, 1, 100) <= 0) {
+            continue;
+        }
+
+        std::vector<std::string> changed;
+        readEvents(changed);
+        std::this_thread::sleep_for(SettleTime);
+        readEvents(changed);
+
+        if (!changed.empty()) {
+            Parse(changed);
+        }
+    }
+
+    close(fd);
+}
+
+#else
+
+void ShaderWatcher::Run()
+{
+    //no inotify, we compare the modification times a few times per second.
+    std::unordered_map<std::string, std::filesystem::file_time_type> times;
+
+    while (m_Running) {
+        Parse({});
+
+        std::vector<std::string> paths;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (const Watched& watched : m_Shaders) {
+                paths.insert(paths.end(), watched.dependencies.begin(), watched.dependencies.end());
+            }
+        }
+
+        std::vector<std::string> changed;
+        for (const std::string& path : paths) {
+            std::error_code error;
+            std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+            if (error) {
+                continue;
+            }
+
+            auto it = times.find(path);
+            if (it == times.end()) {
+                times[path] = time;
+            }
+            else if (it->second != time) {
+                it->second = time;
+                changed.push_back(path);
+            }
+        }
+
+        if (!changed.empty()) {
+            std::this_thread::sleep_for(SettleTime);
+            Parse(changed);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+}
+
+#endif
+
+void ShaderWatcher::Finish(Building& building)
+{
+    if (Shader::FinishProgram(building.program)) {
+        ProgramCache::Store(building.key, building.program);
+        building.shader->Replace(building.program, building.bindings);
+        m_Reloads++;
+        std::cout << "Reloaded " << building.shader->GetFilePath() << std::endl;
+    }
+    else {
+        GLState::DeleteProgram(building.program);
+        m_Failures++;
+        std::cout << "Keeping the previous program of " << building.shader->GetFilePath() << std::endl;
+    }
+}
+
+void ShaderWatcher::Update()
+{
+    //if the thread has the lock right now, whatever it parsed waits until the next frame.
+    std::vector<Parsed> parsed;
+    if (m_Mutex.try_lock()) {
+        parsed.swap(m_Parsed);
+        m_Mutex.unlock();
+    }
+
+    for (Parsed& next : parsed) {
+        //a build of an older version is not worth finishing.
+        for (size_t i = 0; i < m_Building.size(); i++) {
+            if (m_Building[i].shader == next.shader) {
+                GLState::DeleteProgram(m_Building[i].program);
+                m_Building.erase(m_Building.begin() + i);
+                break;
+            }
+        }
+
+        m_Building.push_back({ next.shader, Shader::StartProgram(next.source), ProgramCache::Key(next.source), next.source.Bindings });
+    }
+
+    for (size_t i = 0; i < m_Building.size();) {
+        if (Shader::IsProgramReady(m_Building[i].program)) {
+            Finish(m_Building[i]);
+            m_Building.erase(m_Building.begin() + i);
+        }
+        else {
+            i++;
+        }
+    }
+}
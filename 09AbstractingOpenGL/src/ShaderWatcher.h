@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include "Shader.h"
+
+/*
+* Reloads shaders when their files change on disk. A thread of its own waits for the changes (inotify
+* on Linux, checking the modification times a few times per second elsewhere) and parses the changed
+* .shader files, so the frame loop never touches a file. Update, on the GL thread, compiles and links
+* what was parsed and swaps the new program into the Shader. If it doesn't compile the errors are
+* printed and the Shader keeps the program it had.
+*
+*   ShaderWatcher watcher;
+*   watcher.Watch(shader);
+*   while (...) {
+*       watcher.Update();   //before the shaders are bound, Shader::Replace needs a new Bind
+*       ...
+*   }
+*
+* Files included by a .shader file are watched as well. A watched Shader must be unwatched before it is destroyed.
+*/
+class ShaderWatcher
+{
+private:
+	struct Watched
+	{
+		Shader* shader;
+		std::string path;
+		std::vector<std::string> dependencies;	//path and all it includes, empty until the thread parses it once
+	};
+
+	//parsed by the thread, waiting for the GL thread to compile it
+	struct Parsed
+	{
+		Shader* shader;
+		ShaderProgramSource source;
+	};
+
+	//compiling on the GL thread (with GL_KHR_parallel_shader_compile it can take some frames)
+	struct Building
+	{
+		Shader* shader;
+		unsigned int program;
+		unsigned long long key;
+		std::vector<UniformBlockBinding> bindings;
+	};
+
+	std::mutex m_Mutex;				//guards m_Shaders and m_Parsed
+	std::vector<Watched> m_Shaders;
+	std::vector<Parsed> m_Parsed;
+	std::vector<Building> m_Building;	//only the GL thread sees it
+
+	std::atomic<bool> m_Running;
+	std::atomic<unsigned int> m_Reloads;
+	std::atomic<unsigned int> m_Failures;
+	std::thread m_Thread;
+
+	void Run();
+	//parses the shaders that use any of these paths (or that were never parsed) and queues them for Update.
+	void Parse(const std::vector<std::string>& changed);
+	void Finish(Building& building);
+public:
+	ShaderWatcher();
+	~ShaderWatcher();
+
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+	void Watch(Shader& shader);
+	void Unwatch(Shader& shader);
+
+	//never waits for files or for the thread, only for the driver when there is something to compile.
+	void Update();
+
+	inline unsigned int GetReloadCount() const { return m_Reloads; }
+	inline unsigned int GetFailureCount() const { return m_Failures; }
+};
@@ -0,0 +1,89 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threads)
+    : m_Generation(0), m_Active(0), m_Stop(false), m_Function(nullptr), m_Count(0), m_Grain(1), m_Next(0)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    //the calling thread is the first one.
+    for (unsigned int i = 1; i < threads; i++) {
+        m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Wake.notify_all();
+
+    for (std::thread& worker : m_Workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::RunPieces()
+{
+    for (size_t first = m_Next.fetch_add(m_Grain); first < m_Count; first = m_Next.fetch_add(m_Grain)) {
+        (*m_Function)(first, std::min(first + m_Grain, m_Count));
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    unsigned int generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [&]() { return m_Stop || m_Generation != generation; });
+            if (m_Stop) {
+                return;
+            }
+            generation = m_Generation;
+        }
+
+        RunPieces();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (--m_Active == 0) {
+            m_Done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& function)
+{
+    grain = std::max((size_t)1, grain);
+
+    //not worth waking anybody up
+    if (m_Workers.empty() || count <= grain) {
+        if (count > 0) {
+            function(0, count);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Function = &function;
+        m_Count = count;
+        m_Grain = grain;
+        m_Next = 0;
+        m_Active = (unsigned int)m_Workers.size();
+        m_Generation++;
+    }
+    m_Wake.notify_all();
+
+    RunPieces();
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Done.wait(lock, [&]() { return m_Active == 0; });
+    m_Function = nullptr;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+/*
+* A fixed set of worker threads for data parallel loops. ParallelFor cuts [0, count) in pieces of
+* grain items, the workers and the calling thread take pieces until there are none left, and it
+* returns when all of them are done.
+*
+*   ThreadPool pool;
+*   pool.ParallelFor(count, 4096, [&](size_t first, size_t last) { ... });
+*
+* One ParallelFor at a time; it must not be called from inside another one.
+*/
+class ThreadPool
+{
+private:
+	std::vector<std::thread> m_Workers;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;		//a new loop or the pool is shutting down
+	std::condition_variable m_Done;		//the last worker finished its pieces
+	unsigned int m_Generation;			//loops started so far, the workers wait for it to change
+	unsigned int m_Active;				//workers still on the current loop
+	bool m_Stop;
+
+	const std::function<void(size_t, size_t)>* m_Function;
+	size_t m_Count;
+	size_t m_Grain;
+	std::atomic<size_t> m_Next;			//first item of the next piece
+
+	void WorkerLoop();
+	void RunPieces();
+public:
+	//threads is the total including the caller, 0 is one per core.
+	ThreadPool(unsigned int threads = 0);
+	~ThreadPool();
+
+	void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& function);
+
+	inline unsigned int GetThreadCount() const { return (unsigned int)m_Workers.size() + 1; }
+};
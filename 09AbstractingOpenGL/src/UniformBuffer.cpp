@@ -0,0 +1,63 @@
+#include "UniformBuffer.h"
+#include "Renderer.h"
+#include "GLState.h"
+
+//the std140 rules on a block that has the tricky cases: a float packs into the end of a vec3, array elements
+//take 16 bytes even when they are floats, and a block nested after a mat4 starts on a 16 byte boundary.
+using Std140Check = Std140Layout<Vec3, float, Std140Array<float, 3>, Mat4, Std140Layout<Vec2, float>>;
+static_assert(Std140Check::Offset<0>() == 0, "std140: vec3");
+static_assert(Std140Check::Offset<1>() == 12, "std140: a float after a vec3 uses its last 4 bytes");
+static_assert(Std140Check::Offset<2>() == 16, "std140: arrays align to 16");
+static_assert(Std140Array<float, 3>::Stride == 16 && Std140Array<Vec3, 2>::Stride == 16, "std140: array stride");
+static_assert(Std140Check::Offset<3>() == 64, "std140: mat4 after float[3]");
+static_assert(Std140Check::Offset<4>() == 128, "std140: nested block after a mat4");
+static_assert(Std140Layout<Vec2, float>::Size == 16, "std140: blocks are padded to 16");
+static_assert(Std140Check::Size == 144, "std140: block size");
+
+UniformBuffer::UniformBuffer(unsigned int size)
+    : m_Size(size)
+{
+    GLCall(glGenBuffers(1, &m_RendererID));
+
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+
+    GLCall(glBufferData(
+        GL_UNIFORM_BUFFER,
+        size,               //size in bytes
+        nullptr,            //the contents come later with SetData or Map
+        GL_DYNAMIC_DRAW     //we rewrite it every frame
+    ));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    GLState::DeleteBuffer(m_RendererID);
+}
+
+void UniformBuffer::BindBase(unsigned int binding) const
+{
+    GLState::BindBufferBase(GL_UNIFORM_BUFFER, binding, m_RendererID);
+}
+
+void UniformBuffer::SetData(const void* data, unsigned int size, unsigned int offset)
+{
+    ASSERT(offset + size <= m_Size);
+
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+    GLCall(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+}
+
+void* UniformBuffer::Map()
+{
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+
+    //invalidating lets the driver hand us fresh memory instead of waiting for the GPU to finish with the old one.
+    void* data = GLCallValue(glMapBufferRange(GL_UNIFORM_BUFFER, 0, m_Size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    return data;
+}
+
+void UniformBuffer::Unmap()
+{
+    GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+    GLCall(glUnmapBuffer(GL_UNIFORM_BUFFER));
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "Math.h"
+#include "Renderer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+/*
+* std140 base alignment and size of each type a uniform block can hold.
+* Scalars align to 4, vec2 to 8, vec3 and vec4 to 16, and a mat4 is 4 vec4 columns.
+* Basic is false for arrays and nested blocks, which UniformBlock sets in their own ways.
+*/
+template<typename T>
+struct Std140Type;
+
+template<> struct Std140Type<float> { static constexpr size_t Alignment = 4; static constexpr size_t Size = 4; static constexpr bool Basic = true; };
+template<> struct Std140Type<int> { static constexpr size_t Alignment = 4; static constexpr size_t Size = 4; static constexpr bool Basic = true; };
+template<> struct Std140Type<unsigned int> { static constexpr size_t Alignment = 4; static constexpr size_t Size = 4; static constexpr bool Basic = true; };
+template<> struct Std140Type<Vec2> { static constexpr size_t Alignment = 8; static constexpr size_t Size = 8; static constexpr bool Basic = true; };
+template<> struct Std140Type<Vec3> { static constexpr size_t Alignment = 16; static constexpr size_t Size = 12; static constexpr bool Basic = true; };
+template<> struct Std140Type<Vec4> { static constexpr size_t Alignment = 16; static constexpr size_t Size = 16; static constexpr bool Basic = true; };
+template<> struct Std140Type<Mat4> { static constexpr size_t Alignment = 16; static constexpr size_t Size = 64; static constexpr bool Basic = true; };
+
+constexpr size_t Std140AlignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+/*
+* T[Count] inside a block. Every element is padded to a multiple of 16 bytes.
+*/
+template<typename T, size_t Count>
+struct Std140Array
+{
+	using Element = T;
+	static constexpr size_t Length = Count;
+	static constexpr size_t Stride = Std140AlignUp(Std140Type<T>::Size, 16);
+};
+
+template<typename T, size_t Count>
+struct Std140Type<Std140Array<T, Count>>
+{
+	static constexpr size_t Alignment = 16;
+	static constexpr size_t Size = Std140Array<T, Count>::Stride * Count;
+	static constexpr bool Basic = false;
+};
+
+/*
+* The members of a uniform block, in declaration order:
+*
+*   using MaterialLayout = Std140Layout<Vec4, float, Vec3, Std140Array<Vec4, 4>>;
+*
+* The offset of every member and the size of the block are computed at compile time.
+*/
+template<typename... Members>
+struct Std140Layout
+{
+	static_assert(sizeof...(Members) > 0, "a uniform block needs at least one member");
+
+	static constexpr size_t Count = sizeof...(Members);
+
+	template<size_t I>
+	using Type = typename std::tuple_element<I, std::tuple<Members...>>::type;
+
+private:
+	static constexpr std::array<size_t, Count + 1> ComputeOffsets()
+	{
+		constexpr size_t alignments[] = { Std140Type<Members>::Alignment... };
+		constexpr size_t sizes[] = { Std140Type<Members>::Size... };
+
+		std::array<size_t, Count + 1> offsets = {};
+		size_t offset = 0;
+		for (size_t i = 0; i < Count; i++) {
+			offset = Std140AlignUp(offset, alignments[i]);
+			offsets[i] = offset;
+			offset += sizes[i];
+		}
+
+		//the last entry is the size of the whole block, which is padded like a structure.
+		offsets[Count] = Std140AlignUp(offset, 16);
+		return offsets;
+	}
+
+	static constexpr std::array<size_t, Count + 1> Table = ComputeOffsets();
+
+public:
+	template<size_t I>
+	static constexpr size_t Offset() { return Table[I]; }
+
+	static constexpr size_t Size = Table[Count];
+};
+
+//a block nested in another one behaves like a structure member.
+template<typename... Members>
+struct Std140Type<Std140Layout<Members...>>
+{
+	static constexpr size_t Alignment = 16;
+	static constexpr size_t Size = Std140Layout<Members...>::Size;
+	static constexpr bool Basic = false;
+};
+
+/*
+* CPU copy of a uniform block with the std140 layout. Set writes straight to the final offsets,
+* so the whole block goes to the GPU with a single upload.
+*
+*   block.Set<0>(color);           //a scalar, vector or matrix
+*   block.Set<3>(i, light);        //element i of an array
+*   block.Set<4>(innerBlock);      //a nested block, from a UniformBlock of its layout
+*/
+template<typename Layout>
+class UniformBlock
+{
+private:
+	alignas(16) unsigned char m_Data[Layout::Size];
+public:
+	UniformBlock() { memset(m_Data, 0, sizeof(m_Data)); }
+
+	//a scalar, vector or matrix member
+	template<size_t I>
+	void Set(const typename Layout::template Type<I>& value)
+	{
+		using T = typename Layout::template Type<I>;
+		static_assert(Std140Type<T>::Basic, "arrays are set one element at a time and nested blocks from a UniformBlock");
+		memcpy(m_Data + Layout::template Offset<I>(), &value, Std140Type<T>::Size);
+	}
+
+	//one element of a Std140Array member
+	template<size_t I>
+	void Set(size_t index, const typename Layout::template Type<I>::Element& value)
+	{
+		using A = typename Layout::template Type<I>;
+		ASSERT(index < A::Length);
+		memcpy(m_Data + Layout::template Offset<I>() + index * A::Stride, &value, Std140Type<typename A::Element>::Size);
+	}
+
+	//a nested Std140Layout member, filled in its own UniformBlock
+	template<size_t I, typename Inner>
+	void Set(const UniformBlock<Inner>& block)
+	{
+		static_assert(std::is_same<Inner, typename Layout::template Type<I>>::value, "the block doesn't have the layout of the member");
+		memcpy(m_Data + Layout::template Offset<I>(), block.GetData(), block.GetSize());
+	}
+
+	inline const void* GetData() const { return m_Data; }
+	static constexpr unsigned int GetSize() { return (unsigned int)Layout::Size; }
+};
+
+/*
+* A GL_UNIFORM_BUFFER that backs one or more blocks. Shaders pick it up through the binding point
+* their block was given with a "#binding BlockName N" line in the .shader file.
+*/
+class UniformBuffer
+{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Size;
+public:
+	UniformBuffer(unsigned int size);
+	~UniformBuffer();
+
+	//binds the whole buffer to the binding point
+	void BindBase(unsigned int binding) const;
+
+	//one glBufferSubData
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+
+	//maps the buffer for writing, the previous contents are discarded. Call Unmap when done.
+	void* Map();
+	void Unmap();
+
+	template<typename Layout>
+	void Upload(const UniformBlock<Layout>& block, unsigned int offset = 0)
+	{
+		SetData(block.GetData(), block.GetSize(), offset);
+	}
+
+	inline unsigned int GetSize() const { return m_Size; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+};
@@ -0,0 +1,111 @@
+#include "VertexArray.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "BufferPool.h"
+
+#include <algorithm>
+
+VertexArray::VertexArray()
+    : m_NextLocation(0)
+{
+    GLCall(glGenVertexArrays(1, &m_RendererID));
+}
+
+VertexArray::~VertexArray()
+{
+    GLState::DeleteVertexArray(m_RendererID);
+}
+
+unsigned int VertexArray::GetBufferID(const VertexBuffer& vb)
+{
+    return vb.GetRendererID();
+}
+
+unsigned int VertexArray::GetBufferID(const BufferPool& pool)
+{
+    ASSERT(pool.GetTarget() == GL_ARRAY_BUFFER);
+    return pool.GetRendererID();
+}
+
+void VertexArray::AddBuffer(unsigned int buffer, const VertexAttribute* attributes, unsigned int count, unsigned int stride,
+    unsigned int firstLocation, unsigned int divisor)
+{
+    Bind();
+    GLState::BindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    for (unsigned int i = 0; i < count; i++) {
+        const VertexAttribute& attribute = attributes[i];
+        unsigned int location = firstLocation + i;
+
+        GLCall(glEnableVertexAttribArray(location));
+
+        //this command links the buffer with the vertex array
+        if (attribute.Integer) {
+            GLCall(glVertexAttribIPointer(location, attribute.Components, attribute.Type, stride,
+                (const void*)(size_t)attribute.Offset));
+        }
+        else {
+            GLCall(glVertexAttribPointer(
+                location,                   //index of the attribute
+                attribute.Components,       //num of elements that represents it.
+                attribute.Type,             //the type of the elements
+                attribute.Normalized ? GL_TRUE : GL_FALSE,
+                stride,                     //number of bytes each vertex takes
+                (const void*)(size_t)attribute.Offset //where the attribute is inside the vertex
+            ));
+        }
+
+        if (divisor) {
+            GLCall(glVertexAttribDivisor(location, divisor));
+        }
+
+        if (location >= m_Attributes.size()) {
+            m_Attributes.resize(location + 1, { 0, 0, false, false, 0 });
+        }
+        m_Attributes[location] = attribute;
+    }
+
+    if (firstLocation + count > m_NextLocation) {
+        m_NextLocation = firstLocation + count;
+    }
+    //the attributes changed, every program has to be checked again.
+    m_ValidatedPrograms.clear();
+}
+
+void VertexArray::SetIndexBuffer(const IndexBuffer& ib)
+{
+    Bind();
+    ib.Bind();
+}
+
+void VertexArray::SetIndexBuffer(const BufferPool& pool)
+{
+    ASSERT(pool.GetTarget() == GL_ELEMENT_ARRAY_BUFFER);
+    Bind();
+    pool.Bind();
+}
+
+bool VertexArray::MarkValidated(unsigned long long programRevision) const
+{
+    if (std::find(m_ValidatedPrograms.begin(), m_ValidatedPrograms.end(), programRevision) != m_ValidatedPrograms.end()) {
+        return false;
+    }
+    //hot reloads relink with new revisions, the old ones would pile up. Checking again now and then is cheap.
+    if (m_ValidatedPrograms.size() >= 16) {
+        m_ValidatedPrograms.clear();
+    }
+    m_ValidatedPrograms.push_back(programRevision);
+    return true;
+}
+
+void VertexArray::Bind() const
+{
+    GLState::BindVertexArray(m_RendererID);
+}
+
+void VertexArray::UnBind() const
+{
+    GLState::BindVertexArray(0);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+
+#include "VertexBufferLayout.h"
+
+class VertexBuffer;
+class IndexBuffer;
+class BufferPool;
+
+/*
+* A vertex array object. Each AddBuffer describes one vertex buffer with a VertexBufferLayout:
+* several attributes interleaved in one buffer, or one buffer per attribute stream, or both.
+* Attribute locations continue from one buffer to the next unless a first location is given.
+*
+*   VertexArray va;
+*   va.AddBuffer<Vertex::Layout>(vertices);
+*   va.AddBuffer<Instance::Layout>(instances, 1);  //per instance
+*   va.SetIndexBuffer(ib);
+*
+* A BufferPool can take the place of the buffers, then the vertex array feeds every mesh in the pool
+* and the draws pick one with its base vertex and first index.
+*/
+class VertexArray
+{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_NextLocation;
+	std::vector<VertexAttribute> m_Attributes;	//by location, Components 0 where nothing is enabled
+	mutable std::vector<unsigned long long> m_ValidatedPrograms;	//Shader::GetProgramRevision of the programs checked against the attributes
+
+	//so the templates don't need the buffer headers.
+	static unsigned int GetBufferID(const VertexBuffer& vb);
+	static unsigned int GetBufferID(const BufferPool& pool);
+
+	void AddBuffer(unsigned int buffer, const VertexAttribute* attributes, unsigned int count, unsigned int stride,
+		unsigned int firstLocation, unsigned int divisor);
+public:
+	VertexArray();
+	~VertexArray();
+
+	//divisor 0 reads the buffer once per vertex, N once every N instances.
+	template<typename Layout>
+	void AddBuffer(const VertexBuffer& vb, unsigned int divisor = 0)
+	{
+		AddBuffer(GetBufferID(vb), Layout::Attributes.data(), Layout::Count, Layout::Stride, m_NextLocation, divisor);
+	}
+
+	template<typename Layout>
+	void AddBuffer(const VertexBuffer& vb, unsigned int firstLocation, unsigned int divisor)
+	{
+		AddBuffer(GetBufferID(vb), Layout::Attributes.data(), Layout::Count, Layout::Stride, firstLocation, divisor);
+	}
+
+	//the pool's element size should be Layout::Stride.
+	template<typename Layout>
+	void AddBuffer(const BufferPool& pool, unsigned int divisor = 0)
+	{
+		AddBuffer(GetBufferID(pool), Layout::Attributes.data(), Layout::Count, Layout::Stride, m_NextLocation, divisor);
+	}
+
+	//the element buffer is part of the vertex array state.
+	void SetIndexBuffer(const IndexBuffer& ib);
+	void SetIndexBuffer(const BufferPool& pool);
+
+	void Bind() const;
+	void UnBind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+
+	/*
+	* Remembers that a program was checked against the attributes, and returns false if it already was.
+	* It's forgotten when buffers are added, and the list never holds more than 16 programs.
+	*/
+	bool MarkValidated(unsigned long long programRevision) const;
+
+	//what feeds a location, nullptr if nothing does. Shaders check their inputs against it.
+	inline const VertexAttribute* GetAttribute(unsigned int location) const
+	{
+		return location < m_Attributes.size() && m_Attributes[location].Components ? &m_Attributes[location] : nullptr;
+	}
+};
@@ -1,43 +1,27 @@
 #include "VertexBuffer.h"
 #include "Renderer.h"
 
-VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+VertexBuffer::VertexBuffer(const void* data, unsigned int size, BufferStrategy strategy, unsigned int frames)
+    : m_Storage(GL_ARRAY_BUFFER, data, size, strategy, frames)
 {
-    GLCall(glGenBuffers(
-        1,      //number of buffers
-        &m_RendererID //buffer id
-    ));
-
-    GLCall(glBindBuffer(
-        GL_ARRAY_BUFFER,
-        m_RendererID //we select this buffer to work on it next.
-    ));
-
-    GLCall(glBufferData(
-        GL_ARRAY_BUFFER,
-        size,  //size in bytes
-        data,          //the data
-        GL_STATIC_DRAW      //a hint about the use we are going to make of it
-    ));
 }
 
-VertexBuffer::~VertexBuffer()
+VertexBuffer::VertexBuffer(BufferPool& pool, const void* data, unsigned int size)
+    : m_Storage(pool, data, size)
 {
-    GLCall(glDeleteBuffers(1, &m_RendererID));
 }
 
 void VertexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(
-        GL_ARRAY_BUFFER,
-        m_RendererID //we select this buffer to work on it next.
-    ));
+    m_Storage.Bind();
 }
 
 void VertexBuffer::UnBind() const
 {
-    GLCall(glBindBuffer(
-        GL_ARRAY_BUFFER,
-        0 //to unbind
-    ));
+    m_Storage.UnBind();
+}
+
+void VertexBuffer::Update(unsigned int offset, const void* data, unsigned int size)
+{
+    m_Storage.Update(offset, data, size);
 }
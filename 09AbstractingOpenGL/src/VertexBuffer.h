@@ -1,13 +1,37 @@
 #pragma once
 
+#include "BufferStorage.h"
+
 class VertexBuffer
 {
 private:
-	unsigned int m_RendererID;
+	BufferStorage m_Storage;
 public:
-	VertexBuffer(const void* data, unsigned int size);
-	~VertexBuffer();
+	//see BufferStorage for the strategies. frames only matters for BufferStrategy::Persistent.
+	VertexBuffer(const void* data, unsigned int size, BufferStrategy strategy = BufferStrategy::Static, unsigned int frames = 3);
+	//a range of the pool instead of a buffer of its own, the pool must outlive it. The pool's element size is the size of a vertex.
+	VertexBuffer(BufferPool& pool, const void* data, unsigned int size);
 
 	void Bind() const;
 	void UnBind() const;
-};
\ No newline at end of file
+
+	//writes size bytes at offset with the strategy of this buffer
+	void Update(unsigned int offset, const void* data, unsigned int size);
+
+	//persistent buffers only, see BufferStorage
+	inline void* BeginFrame() { return m_Storage.BeginFrame(); }
+	inline void EndFrame() { m_Storage.EndFrame(); }
+	inline unsigned int GetFrameOffset() const { return m_Storage.GetFrameOffset(); }
+	inline unsigned int GetStalls() const { return m_Storage.GetStalls(); }
+
+	//the first vertex in the buffer, what draws from a pool pass as base vertex. 0 if it isn't in a pool.
+	inline unsigned int GetBaseVertex() const { return m_Storage.GetFirstElement(); }
+	inline unsigned int GetOffset() const { return m_Storage.GetOffset(); }
+
+	//false when it was made in a pool that had no room for it. Don't draw it then.
+	inline bool IsValid() const { return m_Storage.IsValid(); }
+
+	inline unsigned int GetSize() const { return m_Storage.GetSize(); }
+	inline BufferStrategy GetStrategy() const { return m_Storage.GetStrategy(); }
+	inline unsigned int GetRendererID() const { return m_Storage.GetRendererID(); }
+};
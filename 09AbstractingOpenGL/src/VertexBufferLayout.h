@@ -0,0 +1,160 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <cstddef>
+
+#include "Math.h"
+
+//one entry of the attribute table of a layout
+struct VertexAttribute
+{
+	unsigned int Type;		//GL_FLOAT, GL_UNSIGNED_BYTE...
+	int Components;
+	bool Normalized;		//integers read as [0, 1] or [-1, 1] floats
+	bool Integer;			//read as ints by the shader (glVertexAttribIPointer)
+	unsigned int Offset;	//bytes from the start of the vertex
+};
+
+/*
+* How a C++ member type is described to glVertexAttribPointer.
+*/
+template<typename T>
+struct VertexAttributeType;
+
+template<> struct VertexAttributeType<float> { static constexpr unsigned int Type = GL_FLOAT; static constexpr int Components = 1; static constexpr bool Normalized = false; static constexpr bool Integer = false; };
+template<> struct VertexAttributeType<Vec2> { static constexpr unsigned int Type = GL_FLOAT; static constexpr int Components = 2; static constexpr bool Normalized = false; static constexpr bool Integer = false; };
+template<> struct VertexAttributeType<Vec3> { static constexpr unsigned int Type = GL_FLOAT; static constexpr int Components = 3; static constexpr bool Normalized = false; static constexpr bool Integer = false; };
+template<> struct VertexAttributeType<Vec4> { static constexpr unsigned int Type = GL_FLOAT; static constexpr int Components = 4; static constexpr bool Normalized = false; static constexpr bool Integer = false; };
+template<> struct VertexAttributeType<int> { static constexpr unsigned int Type = GL_INT; static constexpr int Components = 1; static constexpr bool Normalized = false; static constexpr bool Integer = true; };
+template<> struct VertexAttributeType<unsigned int> { static constexpr unsigned int Type = GL_UNSIGNED_INT; static constexpr int Components = 1; static constexpr bool Normalized = false; static constexpr bool Integer = true; };
+
+//GL type of the components of the normalized vectors below
+template<typename T> struct VertexComponentType;
+template<> struct VertexComponentType<unsigned char> { static constexpr unsigned int Type = GL_UNSIGNED_BYTE; };
+template<> struct VertexComponentType<signed char> { static constexpr unsigned int Type = GL_BYTE; };
+template<> struct VertexComponentType<unsigned short> { static constexpr unsigned int Type = GL_UNSIGNED_SHORT; };
+template<> struct VertexComponentType<short> { static constexpr unsigned int Type = GL_SHORT; };
+
+/*
+* N integers the shader reads as a normalized float vector, e.g. Normalized<unsigned char, 4> for an RGBA8 colour.
+*/
+template<typename T, int N>
+struct Normalized
+{
+	T v[N];
+};
+
+template<typename T, int N>
+struct VertexAttributeType<Normalized<T, N>>
+{
+	static constexpr unsigned int Type = VertexComponentType<T>::Type;
+	static constexpr int Components = N;
+	static constexpr bool Normalized = true;
+	static constexpr bool Integer = false;
+};
+
+/*
+* N half floats (GL_HALF_FLOAT), see PackHalf.
+*/
+template<int N>
+struct Half
+{
+	unsigned short v[N];
+};
+
+template<int N>
+struct VertexAttributeType<Half<N>>
+{
+	static constexpr unsigned int Type = GL_HALF_FLOAT;
+	static constexpr int Components = N;
+	static constexpr bool Normalized = false;
+	static constexpr bool Integer = false;
+};
+
+/*
+* x, y and z with 10 bits and w with 2 in one integer, read as a normalized vec4.
+* The signed one is for normals and tangents (w the handedness), the unsigned one for colours.
+* See PackSnorm1010102 and PackUnorm1010102.
+*/
+struct Snorm1010102
+{
+	unsigned int v;
+};
+
+struct Unorm1010102
+{
+	unsigned int v;
+};
+
+template<> struct VertexAttributeType<Snorm1010102> { static constexpr unsigned int Type = GL_INT_2_10_10_10_REV; static constexpr int Components = 4; static constexpr bool Normalized = true; static constexpr bool Integer = false; };
+template<> struct VertexAttributeType<Unorm1010102> { static constexpr unsigned int Type = GL_UNSIGNED_INT_2_10_10_10_REV; static constexpr int Components = 4; static constexpr bool Normalized = true; static constexpr bool Integer = false; };
+
+//a unit vector folded onto an octahedron in two normalized shorts. The shader unfolds it, see PackOctahedral.
+using Octahedral = Normalized<short, 2>;
+
+/*
+* The attributes of a vertex structure, its members in declaration order:
+*
+*   struct Vertex
+*   {
+*       Vec2 Position;
+*       Vec4 Color;
+*       using Layout = VertexBufferLayout<Vertex, Vec2, Vec4>;
+*   };
+*
+* Offsets follow the C++ alignment rules, so they match the structure, and the stride is its size.
+* Everything is computed at compile time; a member missing from the list fails the static_assert.
+*/
+template<typename Vertex, typename... Members>
+struct VertexBufferLayout
+{
+	static constexpr unsigned int Count = sizeof...(Members);
+	static constexpr unsigned int Stride = sizeof(Vertex);
+
+private:
+	static constexpr size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	static constexpr std::array<VertexAttribute, Count> Build()
+	{
+		constexpr size_t sizes[] = { sizeof(Members)... };
+		constexpr size_t alignments[] = { alignof(Members)... };
+		constexpr unsigned int types[] = { VertexAttributeType<Members>::Type... };
+		constexpr int components[] = { VertexAttributeType<Members>::Components... };
+		constexpr bool normalized[] = { VertexAttributeType<Members>::Normalized... };
+		constexpr bool integer[] = { VertexAttributeType<Members>::Integer... };
+
+		std::array<VertexAttribute, Count> attributes = {};
+		size_t offset = 0;
+		for (size_t i = 0; i < Count; i++) {
+			offset = AlignUp(offset, alignments[i]);
+			attributes[i] = { types[i], components[i], normalized[i], integer[i], (unsigned int)offset };
+			offset += sizes[i];
+		}
+		return attributes;
+	}
+
+	static constexpr size_t End()
+	{
+		constexpr size_t sizes[] = { sizeof(Members)... };
+		constexpr size_t alignments[] = { alignof(Members)... };
+
+		size_t offset = 0;
+		size_t alignment = 1;
+		for (size_t i = 0; i < Count; i++) {
+			offset = AlignUp(offset, alignments[i]) + sizes[i];
+			alignment = alignments[i] > alignment ? alignments[i] : alignment;
+		}
+		return AlignUp(offset, alignment);
+	}
+
+	static_assert(sizeof...(Members) > 0, "a vertex needs at least one attribute");
+	static_assert(End() == sizeof(Vertex), "the members don't add up to the vertex structure");
+
+public:
+	static constexpr std::array<VertexAttribute, Count> Attributes = Build();
+};
@@ -0,0 +1,324 @@
+#include "VertexPacking.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VERTEX_PACKING_SSE2
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VERTEX_PACKING_AVX2
+#endif
+
+//MSVC has no __F16C__, but every CPU with AVX2 has F16C too.
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#include <immintrin.h>
+#define VERTEX_PACKING_F16C
+#endif
+
+/*
+* Float to half rounding to nearest even, from Fabian Giesen's float_to_half_fast3_rtne.
+* NaNs become the canonical quiet NaN.
+*/
+static unsigned short FloatToHalf(float value)
+{
+    unsigned int f;
+    memcpy(&f, &value, sizeof(f));
+
+    unsigned int sign = f & 0x80000000u;
+    f ^= sign;
+
+    unsigned short half;
+    if (f >= 0x47800000u) {
+        //too big for a half (or already infinite or NaN)
+        half = f > 0x7F800000u ? 0x7E00 : 0x7C00;
+    }
+    else if (f < 0x38800000u) {
+        //a denormal half. Adding 0.5 lines the 10 bits of mantissa up at the bottom of the float
+        //and the FPU does the rounding for us.
+        const float magic = 0.5f;
+        float shifted;
+        memcpy(&shifted, &f, sizeof(shifted));
+        shifted += magic;
+
+        unsigned int bits, magicBits;
+        memcpy(&bits, &shifted, sizeof(bits));
+        memcpy(&magicBits, &magic, sizeof(magicBits));
+        half = (unsigned short)(bits - magicBits);
+    }
+    else {
+        unsigned int odd = (f >> 13) & 1;
+        f += ((15u - 127u) << 23) + 0xFFF + odd; //rebias the exponent and round the 13 bits we drop
+        half = (unsigned short)(f >> 13);
+    }
+    return half | (unsigned short)(sign >> 16);
+}
+
+//clamps to [low, high], scales and rounds to nearest even. The comparisons are written like
+//_mm_max_ps and _mm_min_ps so NaN ends up as low, like in the SIMD paths.
+static inline int Quantize(float value, float low, float high, float scale)
+{
+    value = value > low ? value : low;
+    value = value < high ? value : high;
+    return (int)std::nearbyint(value * scale);
+}
+
+#ifdef VERTEX_PACKING_SSE2
+//Quantize on 8 floats, the results in two groups of 4.
+static inline void Quantize8(const float* source, float low, float high, float scale, __m128i& first, __m128i& second)
+{
+#ifdef VERTEX_PACKING_AVX2
+    __m256 value = _mm256_loadu_ps(source);
+    value = _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(low)), _mm256_set1_ps(high));
+    __m256i quantized = _mm256_cvtps_epi32(_mm256_mul_ps(value, _mm256_set1_ps(scale)));
+
+    first = _mm256_castsi256_si128(quantized);
+    second = _mm256_extracti128_si256(quantized, 1);
+#else
+    const __m128 lowValue = _mm_set1_ps(low);
+    const __m128 highValue = _mm_set1_ps(high);
+    const __m128 scaleValue = _mm_set1_ps(scale);
+
+    __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source), lowValue), highValue);
+    __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + 4), lowValue), highValue);
+
+    first = _mm_cvtps_epi32(_mm_mul_ps(a, scaleValue));
+    second = _mm_cvtps_epi32(_mm_mul_ps(b, scaleValue));
+#endif
+}
+
+static inline __m128i Quantize4(__m128 value, float low, float high, float scale)
+{
+    value = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(low)), _mm_set1_ps(high));
+    return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(scale)));
+}
+#endif
+
+//halves of count floats, same number of components on both sides.
+static void PackHalfFlat(unsigned short* destination, const float* source, size_t count)
+{
+    size_t i = 0;
+
+#ifdef VERTEX_PACKING_F16C
+    for (; i + 8 <= count; i += 8) {
+        __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*)(destination + i), halves);
+    }
+#endif
+
+    for (; i < count; i++) {
+        destination[i] = FloatToHalf(source[i]);
+    }
+}
+
+void PackHalf(unsigned short* destination, const float* source, size_t count, unsigned int sourceComponents, unsigned int destinationComponents)
+{
+    if (sourceComponents == destinationComponents) {
+        PackHalfFlat(destination, source, count * sourceComponents);
+        return;
+    }
+
+    //we line the vectors up with the destination in blocks on the stack and convert each block in one go.
+    const size_t blockFloats = 1024;
+    float block[blockFloats];
+    size_t blockVectors = blockFloats / destinationComponents;
+    unsigned int copied = sourceComponents < destinationComponents ? sourceComponents : destinationComponents;
+
+    for (size_t first = 0; first < count; first += blockVectors) {
+        size_t vectors = count - first < blockVectors ? count - first : blockVectors;
+
+        for (size_t v = 0; v < vectors; v++) {
+            float* vector = block + v * destinationComponents;
+            const float* from = source + (first + v) * sourceComponents;
+
+            for (unsigned int c = 0; c < destinationComponents; c++) {
+                vector[c] = c < copied ? from[c] : 0.0f;
+            }
+        }
+
+        PackHalfFlat(destination + first * destinationComponents, block, vectors * destinationComponents);
+    }
+}
+
+void PackUnorm8(unsigned char* destination, const float* source, size_t count)
+{
+    size_t i = 0;
+
+#ifdef VERTEX_PACKING_SSE2
+    for (; i + 8 <= count; i += 8) {
+        __m128i a, b;
+        Quantize8(source + i, 0.0f, 1.0f, 255.0f, a, b);
+
+        __m128i shorts = _mm_packs_epi32(a, b);
+        _mm_storel_epi64((__m128i*)(destination + i), _mm_packus_epi16(shorts, shorts));
+    }
+#endif
+
+    for (; i < count; i++) {
+        destination[i] = (unsigned char)Quantize(source[i], 0.0f, 1.0f, 255.0f);
+    }
+}
+
+void PackSnorm8(signed char* destination, const float* source, size_t count)
+{
+    size_t i = 0;
+
+#ifdef VERTEX_PACKING_SSE2
+    for (; i + 8 <= count; i += 8) {
+        __m128i a, b;
+        Quantize8(source + i, -1.0f, 1.0f, 127.0f, a, b);
+
+        __m128i shorts = _mm_packs_epi32(a, b);
+        _mm_storel_epi64((__m128i*)(destination + i), _mm_packs_epi16(shorts, shorts));
+    }
+#endif
+
+    for (; i < count; i++) {
+        destination[i] = (signed char)Quantize(source[i], -1.0f, 1.0f, 127.0f);
+    }
+}
+
+void PackUnorm16(unsigned short* destination, const float* source, size_t count)
+{
+    size_t i = 0;
+
+#ifdef VERTEX_PACKING_SSE2
+    //SSE2 only packs with signed saturation, so we move [0, 65535] to [-32768, 32767] and flip the top bit back.
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i a, b;
+        Quantize8(source + i, 0.0f, 1.0f, 65535.0f, a, b);
+
+        __m128i packed = _mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32));
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_xor_si128(packed, bias16));
+    }
+#endif
+
+    for (; i < count; i++) {
+        destination[i] = (unsigned short)Quantize(source[i], 0.0f, 1.0f, 65535.0f);
+    }
+}
+
+void PackSnorm16(short* destination, const float* source, size_t count)
+{
+    size_t i = 0;
+
+#ifdef VERTEX_PACKING_SSE2
+    for (; i + 8 <= count; i += 8) {
+        __m128i a, b;
+        Quantize8(source + i, -1.0f, 1.0f, 32767.0f, a, b);
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_packs_epi32(a, b));
+    }
+#endif
+
+    for (; i < count; i++) {
+        destination[i] = (short)Quantize(source[i], -1.0f, 1.0f, 32767.0f);
+    }
+}
+
+/*
+* Both 10_10_10_2 formats: x in the low 10 bits, then y, z and w in the top 2.
+* The signed one keeps two's complement fields, so we just mask them.
+*/
+static void Pack1010102(unsigned int* destination, const Vec4* source, size_t count, float low, float scale, float scaleW)
+{
+    size_t i = 0;
+
+#ifdef VERTEX_PACKING_SSE2
+    const __m128i mask10 = _mm_set1_epi32(0x3FF);
+    const __m128i mask2 = _mm_set1_epi32(0x3);
+
+    for (; i + 4 <= count; i += 4) {
+        //four vectors in, four x, four y, four z and four w out
+        __m128 x = _mm_loadu_ps(&source[i].x);
+        __m128 y = _mm_loadu_ps(&source[i + 1].x);
+        __m128 z = _mm_loadu_ps(&source[i + 2].x);
+        __m128 w = _mm_loadu_ps(&source[i + 3].x);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        __m128i packed = _mm_and_si128(Quantize4(x, low, 1.0f, scale), mask10);
+        packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_and_si128(Quantize4(y, low, 1.0f, scale), mask10), 10));
+        packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_and_si128(Quantize4(z, low, 1.0f, scale), mask10), 20));
+        packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_and_si128(Quantize4(w, low, 1.0f, scaleW), mask2), 30));
+
+        _mm_storeu_si128((__m128i*)(destination + i), packed);
+    }
+#endif
+
+    for (; i < count; i++) {
+        const Vec4& v = source[i];
+        destination[i] = ((unsigned int)Quantize(v.x, low, 1.0f, scale) & 0x3FF)
+            | (((unsigned int)Quantize(v.y, low, 1.0f, scale) & 0x3FF) << 10)
+            | (((unsigned int)Quantize(v.z, low, 1.0f, scale) & 0x3FF) << 20)
+            | (((unsigned int)Quantize(v.w, low, 1.0f, scaleW) & 0x3) << 30);
+    }
+}
+
+void PackSnorm1010102(unsigned int* destination, const Vec4* source, size_t count)
+{
+    Pack1010102(destination, source, count, -1.0f, 511.0f, 1.0f);
+}
+
+void PackUnorm1010102(unsigned int* destination, const Vec4* source, size_t count)
+{
+    Pack1010102(destination, source, count, 0.0f, 1023.0f, 3.0f);
+}
+
+void PackOctahedral(short* destination, const Vec3* source, size_t count)
+{
+    size_t i = 0;
+
+#ifdef VERTEX_PACKING_SSE2
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= count; i += 4) {
+        const Vec3* n = source + i;
+        __m128 x = _mm_setr_ps(n[0].x, n[1].x, n[2].x, n[3].x);
+        __m128 y = _mm_setr_ps(n[0].y, n[1].y, n[2].y, n[3].y);
+        __m128 z = _mm_setr_ps(n[0].z, n[1].z, n[2].z, n[3].z);
+
+        //project onto the octahedron |x| + |y| + |z| = 1
+        __m128 length = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(signMask, x), _mm_andnot_ps(signMask, y)), _mm_andnot_ps(signMask, z));
+        //a zero normal has no direction, it gets (0, 0) which decodes to +z instead of NaN.
+        __m128 nonZero = _mm_cmpgt_ps(length, _mm_setzero_ps());
+        __m128 px = _mm_and_ps(nonZero, _mm_div_ps(x, length));
+        __m128 py = _mm_and_ps(nonZero, _mm_div_ps(y, length));
+
+        //the lower half folds over the diagonals
+        __m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, py)), _mm_or_ps(_mm_and_ps(px, signMask), one));
+        __m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, px)), _mm_or_ps(_mm_and_ps(py, signMask), one));
+        __m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+        px = _mm_or_ps(_mm_and_ps(lower, foldedX), _mm_andnot_ps(lower, px));
+        py = _mm_or_ps(_mm_and_ps(lower, foldedY), _mm_andnot_ps(lower, py));
+
+        //x0 y0 x1 y1 ...
+        __m128i qx = Quantize4(px, -1.0f, 1.0f, 32767.0f);
+        __m128i qy = Quantize4(py, -1.0f, 1.0f, 32767.0f);
+        __m128i packed = _mm_packs_epi32(_mm_unpacklo_epi32(qx, qy), _mm_unpackhi_epi32(qx, qy));
+        _mm_storeu_si128((__m128i*)(destination + i * 2), packed);
+    }
+#endif
+
+    for (; i < count; i++) {
+        const Vec3& n = source[i];
+        float length = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        float px = length > 0.0f ? n.x / length : 0.0f;
+        float py = length > 0.0f ? n.y / length : 0.0f;
+
+        if (n.z < 0.0f) {
+            float foldedX = (1.0f - std::fabs(py)) * std::copysign(1.0f, px);
+            float foldedY = (1.0f - std::fabs(px)) * std::copysign(1.0f, py);
+            px = foldedX;
+            py = foldedY;
+        }
+
+        destination[i * 2] = (short)Quantize(px, -1.0f, 1.0f, 32767.0f);
+        destination[i * 2 + 1] = (short)Quantize(py, -1.0f, 1.0f, 32767.0f);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Math.h"
+
+/*
+* Converts float attributes to the compact formats of VertexBufferLayout.h before they are uploaded.
+* Every function converts count values from one tightly packed array to another, so each attribute
+* ends up in its own stream; VertexArray::AddBuffer takes one buffer per stream.
+*
+*   std::vector<Half<4>> positions(n);
+*   PackHalf(positions.data(), source, n, 3, 4);        //xyz floats to xyz0 halves
+*   VertexBuffer vb(positions.data(), n * sizeof(Half<4>));
+*   va.AddBuffer<VertexBufferLayout<Half<4>, Half<4>>>(vb);
+*
+* They use F16C, AVX2 or SSE2 when the compiler targets them, and plain C++ otherwise.
+* Every path rounds to the nearest value, ties to even, so they all give the same bits.
+*/
+
+//count vectors of sourceComponents floats to vectors of destinationComponents halves, missing components are 0.
+void PackHalf(unsigned short* destination, const float* source, size_t count, unsigned int sourceComponents = 1, unsigned int destinationComponents = 1);
+
+//count floats clamped to [0, 1] or [-1, 1] to normalized integers.
+void PackUnorm8(unsigned char* destination, const float* source, size_t count);
+void PackSnorm8(signed char* destination, const float* source, size_t count);
+void PackUnorm16(unsigned short* destination, const float* source, size_t count);
+void PackSnorm16(short* destination, const float* source, size_t count);
+
+//count vectors to 10_10_10_2. w only has 2 bits: -1, 0 or 1 for the signed one and 0 to 3 thirds for the unsigned one.
+void PackSnorm1010102(unsigned int* destination, const Vec4* source, size_t count);
+void PackUnorm1010102(unsigned int* destination, const Vec4* source, size_t count);
+
+/*
+* count unit vectors to two normalized shorts each (4 bytes instead of 12). The vertex shader unfolds them with:
+*
+*   vec3 OctahedralDecode(vec2 e)
+*   {
+*       vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+*       float t = max(-n.z, 0.0);
+*       n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+*       return normalize(n);
+*   }
+*/
+void PackOctahedral(short* destination, const Vec3* source, size_t count);